@@ -16,9 +16,10 @@
 -- with this program; if not, write to the Free Software Foundation, Inc.,
 -- 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 
-PRAGMA user_version = 1;
+PRAGMA user_version = 6;
 PRAGMA foreign_keys = true;
 
+DROP TRIGGER IF EXISTS LessonListAfterDelete;
 DROP TRIGGER IF EXISTS LessonListBeforeDelete;
 DROP TRIGGER IF EXISTS LessonListBeforeChildIdUpdate;
 DROP TRIGGER IF EXISTS LessonListAfterInsertHead;
@@ -29,6 +30,11 @@ DROP VIEW IF EXISTS vLessons;
 DROP VIEW IF EXISTS vLessonListForward;
 DROP VIEW IF EXISTS vDanglingLessons;
 
+DROP INDEX IF EXISTS idxStatsProfileStart;
+DROP INDEX IF EXISTS idxLessonListLesson;
+DROP INDEX IF EXISTS idxLessonListChild;
+DROP INDEX IF EXISTS idxLessonListParent;
+DROP TABLE IF EXISTS tblLessonGc;
 DROP TABLE IF EXISTS tblStats;
 DROP TABLE IF EXISTS tblLessonList;
 DROP TABLE IF EXISTS tblCourse;
@@ -49,11 +55,11 @@ CREATE TABLE IF NOT EXISTS tblProfile (
 ) WITHOUT ROWID;
 
 -- Table that holds the lessons.
--- Each lesson has a UUID taken from Ktouch, stored as text and used as PK.
+-- Each lesson has a UUID taken from Ktouch, stored as 16 byte BLOB (RFC 4122) and used as PK.
 -- The builtin flag is used to destinguish between user defined/created lessons and those delivered with the binary.
 -- Lessons that are not attached to any Course can be found with the help of vDanglingLessons.
 CREATE TABLE IF NOT EXISTS tblLesson (
-	pkLessonUuid		TEXT NOT NULL PRIMARY KEY,
+	pkLessonUuid		BLOB NOT NULL PRIMARY KEY,
 	cLessonTitle		TEXT NOT NULL,
 	cNewChars			TEXT,
 	cLessonBuiltin		NUMERIC NOT NULL DEFAULT 0,
@@ -61,11 +67,12 @@ CREATE TABLE IF NOT EXISTS tblLesson (
 ) WITHOUT ROWID;
 
 -- A course is mainly a collection of lessons.
+-- The UUID is stored as 16 byte BLOB like the one of the lessons.
 -- Courses without any Lessons are allowed.
 -- The right order of the lessons is ensured by the LessonList table.
 -- Each course holds a reference to its first lesson list entry.
 CREATE TABLE IF NOT EXISTS tblCourse (
-	pkCourseUuid		TEXT NOT NULL PRIMARY KEY,
+	pkCourseUuid		BLOB NOT NULL PRIMARY KEY,
 	cCourseTitle		TEXT NOT NULL,
 	cDescription		TEXT,
 	cCourseBuiltin		NUMERIC NOT NULL DEFAULT 0
@@ -84,22 +91,29 @@ CREATE TABLE IF NOT EXISTS tblCourse (
 --  HINT: The GUI should make such a constallation impossible by using e.g. a drag and drop system.
 CREATE TABLE IF NOT EXISTS tblLessonList (
 	pkLessonListId		INTEGER PRIMARY KEY AUTOINCREMENT,
-	fkCourseUuid		TEXT REFERENCES tblCourse(pkCourseUuid) ON UPDATE CASCADE ON DELETE CASCADE,
-	fkLessonUuid		TEXT NOT NULL REFERENCES tblLesson(pkLessonUuid) ON UPDATE CASCADE ON DELETE CASCADE,
+	fkCourseUuid		BLOB REFERENCES tblCourse(pkCourseUuid) ON UPDATE CASCADE ON DELETE CASCADE,
+	fkLessonUuid		BLOB NOT NULL REFERENCES tblLesson(pkLessonUuid) ON UPDATE CASCADE ON DELETE CASCADE,
 	-- List handling
 	fkParentId			INTEGER DEFAULT NULL REFERENCES tblLessonList(pkLessonListId),
 	fkChildId			INTEGER DEFAULT NULL REFERENCES tblLessonList(pkLessonListId),
 	UNIQUE(fkCourseUuid,fkLessonUuid)
 );
 
+-- The list pointers are looked up by the triggers and by the foreign key actions on deletion.
+-- Lesson references are looked up when searching dangling lessons.
+CREATE INDEX IF NOT EXISTS idxLessonListParent ON tblLessonList(fkParentId);
+CREATE INDEX IF NOT EXISTS idxLessonListChild ON tblLessonList(fkChildId);
+CREATE INDEX IF NOT EXISTS idxLessonListLesson ON tblLessonList(fkLessonUuid);
+
 -- Ensure the list head is connected to a valid course before insert.
 -- Ensure that a child does not specify a different course than its parent.
 CREATE TRIGGER IF NOT EXISTS LessonListBeforeInsert BEFORE INSERT ON tblLessonList
 BEGIN
-	SELECT RAISE(ABORT, 'LessonList constraint failed: List head lacks course') FROM tblLessonList
+	-- No FROM clause: The checks must not loop over the list
+	SELECT RAISE(ABORT, 'LessonList constraint failed: List head lacks course')
 		WHERE NEW.fkParentId ISNULL AND (SELECT pkCourseUuid FROM tblCourse WHERE pkCourseUuid = NEW.fkCourseUuid) ISNULL;
 
-	SELECT RAISE(ABORT, 'LessonList constraint failed: Wrong course ID') FROM tblLessonList
+	SELECT RAISE(ABORT, 'LessonList constraint failed: Wrong course ID')
 		WHERE NEW.fkParentId NOTNULL AND (SELECT fkCourseUuid FROM tblLessonList WHERE pkLessonListId = NEW.fkParentId) != NEW.fkCourseUuid;
 END;
 
@@ -150,6 +164,17 @@ BEGIN
 	UPDATE tblLessonList SET fkParentId = OLD.fkParentId WHERE pkLessonListId = OLD.fkChildId;
 END;
 
+-- Each Lesson that loses a LessonList entry becomes a candidate for the garbage collection.
+-- The collection only has to check the candidates instead of searching the whole Lesson table.
+CREATE TABLE IF NOT EXISTS tblLessonGc (
+	pkLessonUuid		BLOB NOT NULL PRIMARY KEY
+) WITHOUT ROWID;
+
+CREATE TRIGGER IF NOT EXISTS LessonListAfterDelete AFTER DELETE ON tblLessonList
+BEGIN
+	INSERT OR IGNORE INTO tblLessonGc VALUES (OLD.fkLessonUuid);
+END;
+
 -- Search for dangling Lessons
 CREATE VIEW IF NOT EXISTS vDanglingLessons AS
 SELECT pkLessonUuid FROM tblLesson WHERE pkLessonUuid NOT IN  (SELECT fkLessonUuid FROM tblLessonList);
@@ -186,20 +211,23 @@ JOIN tblCourse ON pkCourseUuid = fkCourseUuid;
 
 -- Table for statistics of passed lessons.
 -- Has a composite PK of the lesson UUID, the profile name and the start date.
--- DateTimes are stored in ISO format (e.g. 2015-07-01T14:44:52+0200 or higher precision).
+-- DateTimes are stored as milliseconds since the epoch (UTC). The application converts them to local time.
+-- Time range queries of a profile are backed by idxStatsProfileStart.
 -- The stats does not depend on the LessonList entries anymore. That has the advantage that LessonList entries
 --	can be deleted and stored in another order without invalidating the stats.
 -- When the profile or the lesson is deleted, the stats are deleted too.
 CREATE TABLE IF NOT EXISTS tblStats (
 	pkfkLessonListId	INTEGER NOT NULL REFERENCES tblLessonList(pkLessonListId) ON UPDATE CASCADE ON DELETE CASCADE,
 	pkfkProfileName		TEXT NOT NULL REFERENCES tblProfile(pkProfileName) ON UPDATE CASCADE ON DELETE CASCADE,
-	pkStartDateTime		TEXT NOT NULL,
+	pkStartDateTime		INTEGER NOT NULL,
 	cTime				INTEGER NOT NULL,
 	cCharCount			INTEGER NOT NULL,
 	cErrorCount			INTEGER,
 	PRIMARY KEY(pkfkLessonListId, pkfkProfileName, pkStartDateTime)
 ) WITHOUT ROWID;
 
+CREATE INDEX IF NOT EXISTS idxStatsProfileStart ON tblStats(pkfkProfileName, pkStartDateTime);
+
 
 -- *****************************
 -- TESTS
@@ -304,21 +332,21 @@ ROLLBACK;
 INSERT INTO tblStats VALUES (
 	(SELECT pkLessonListId FROM tblLessonList WHERE fkCourseUuid = 'C1' AND fkLessonUuid = 'L1'),
 	'TestUser1',
-	strftime('%Y-%m-%dT%H:%M:%f','now'),
+	CAST((julianday('now') - 2440587.5) * 86400000 AS INTEGER),
 	60000,
 	220,
 	10
 ), (
 	(SELECT pkLessonListId FROM tblLessonList WHERE fkCourseUuid = 'C1' AND fkLessonUuid = 'L1'),
 	'TestUser1',
-	strftime('%Y-%m-%dT%H:%M:%f','now','+1 minutes'),
+	CAST((julianday('now','+1 minutes') - 2440587.5) * 86400000 AS INTEGER),
 	60000,
 	240,
 	12
 ), (
 	(SELECT pkLessonListId FROM tblLessonList WHERE fkCourseUuid = 'C2' AND fkLessonUuid = 'L2'),
 	'TestUser1',
-	strftime('%Y-%m-%dT%H:%M:%f','now','+2 minutes'),
+	CAST((julianday('now','+2 minutes') - 2440587.5) * 86400000 AS INTEGER),
 	60000,
 	210,
 	16
@@ -328,6 +356,8 @@ SELECT 'Stats: Wrong row count'
 
 -- HINT: Get stats with course and lesson titles
 --SELECT * FROM tblStats JOIN vLessons ON pkLessonListId = pkfkLessonListId WHERE pkfkProfileName = 'TestUser1';
+-- HINT: Without titles join tblLessonList directly, vLessons expands the lists of all courses
+--SELECT * FROM tblStats JOIN tblLessonList ON pkLessonListId = pkfkLessonListId WHERE pkfkProfileName = 'TestUser1';
 
 -- Delete a course and check the delete cascades
 BEGIN TRANSACTION;
@@ -346,6 +376,20 @@ SELECT 'Stats: Wrong row count'
 	WHERE (SELECT count(*) FROM tblStats) != 1;
 ROLLBACK;
 
+-- Delete a course and collect the dangling built-in Lessons through the candidates
+BEGIN TRANSACTION;
+DELETE FROM tblCourse WHERE pkCourseUuid = 'C1';
+SELECT 'LessonGc: Wrong candidate count'
+	WHERE (SELECT count(*) FROM tblLessonGc) != 4;
+DELETE FROM tblLesson WHERE pkLessonUuid IN (SELECT pkLessonUuid FROM tblLessonGc ORDER BY pkLessonUuid LIMIT 10)
+	AND cLessonBuiltin AND NOT EXISTS (SELECT 1 FROM tblLessonList WHERE fkLessonUuid = tblLesson.pkLessonUuid);
+DELETE FROM tblLessonGc WHERE pkLessonUuid IN (SELECT pkLessonUuid FROM tblLessonGc ORDER BY pkLessonUuid LIMIT 10);
+-- Only L1 is built-in and unused
+SELECT 'LessonGc: Wrong row count'
+	WHERE (SELECT count(*) FROM tblLesson) != 3 OR (SELECT count(*) FROM tblLesson WHERE pkLessonUuid = 'L1') != 0
+	OR (SELECT count(*) FROM tblLessonGc) != 0;
+ROLLBACK;
+
 -- Check updates
 BEGIN TRANSACTION;
 
@@ -168,10 +168,19 @@ CourseModel::CourseModel(QObject* parent):
 }
 
 CourseModel::CourseModel(DataModel* model, QObject* parent):
-	QAbstractListModel(parent), mDm(model)
+	QAbstractListModel(parent), mDm(model), mSelected(-1)
 {
 	mLessonModel = new LessonModel(mDm, this);
-	selectCourse(0);
+
+	// Courses are inserted while the DataModel is loaded
+	connect(mDm, &DataModel::coursesAboutToBeInserted, this, [this](int first, int last)
+	{
+		beginInsertRows(QModelIndex(), first, last);
+	});
+	connect(mDm, &DataModel::coursesInserted, this, &CourseModel::onCoursesInserted);
+
+	if (mDm->getCourseCount())
+		selectCourse(0);
 }
 
 CourseModel::~CourseModel()
@@ -263,6 +272,23 @@ void CourseModel::selectCourse(int index)
 	}
 }
 
+/* Select the first course or keep the selected one when rows are inserted before it */
+void CourseModel::onCoursesInserted(int first, int last)
+{
+	endInsertRows();
+
+	if (mSelected < 0)
+	{
+		selectCourse(0);
+	}
+	else if (first <= mSelected)
+	{
+		mSelected += last - first + 1;
+		mLessonModel->setCourse(mSelected);
+		emit indexChanged();
+	}
+}
+
 QmlCourse* CourseModel::getCourse() const
 {
 	QmlCourse* result = nullptr;
@@ -138,6 +138,9 @@ signals:
 protected:
 	virtual QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
 
+private slots:
+	void onCoursesInserted(int first, int last);
+
 private:
 	DataModel* mDm;
 
@@ -29,96 +29,413 @@
 #include <map>
 
 #include <QDir>
+#include <QTimer>
+#include <QRunnable>
+#include <QMetaObject>
 #include <QDebug>
 
+#include "utils/exceptions.hpp"
 #include "xml/parser.hpp"
+#include "xml/manifest.hpp"
 #include "db/dbv1.hpp"
 #include "db/dbhelper.hpp"
+#include "startuptracer.hpp"
 
 namespace qtouch
 {
 
+namespace
+{
+
+/* Lessons checked per event loop iteration */
+const int LESSON_GC_BATCH_SIZE = 50;
+
+/* Closes the connection of the worker on every exit from the load.
+ * The connection belongs to the thread that opened it. It's reopened on demand. */
+class WorkerConnectionGuard
+{
+public:
+	WorkerConnectionGuard(const std::shared_ptr<DbInterface>& db, bool onWorker) : mDb(db), mOnWorker(onWorker) {}
+	~WorkerConnectionGuard() { close(); }
+
+	void close()
+	{
+		if (mOnWorker && mDb)
+			mDb->close();
+		mOnWorker = false;
+	}
+
+private:
+	const std::shared_ptr<DbInterface>& mDb;
+	bool mOnWorker;
+};
+
+} /* namespace */
+
+/* Loads the data model on the worker */
+class DataModel::InitTask: public QRunnable
+{
+public:
+	explicit InitTask(DataModel* dm) : mDm(dm) {}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		try
+		{
+			mDm->load();
+		}
+		catch (const Exception& e)
+		{
+			QMetaObject::invokeMethod(mDm, "fail", Qt::QueuedConnection, Q_ARG(QString, e.message()));
+		}
+	}
+
+private:
+	DataModel* mDm;
+};
+
 DataModel::DataModel(QObject* parent) :
-	QObject(parent)
+	QObject(parent), mDelivery(Qt::DirectConnection), mCancel(false), mReady(false), mProgressDone(0),
+	mProgressTotal(0), mReclaimedLessons(0), mDatabaseFile(QStringLiteral("QTouch.sqlite")), mParsedCount(0)
 {
+	mWorker.setMaxThreadCount(1);
 }
 
 DataModel::~DataModel()
 {
+	mCancel = true;
+	mWorker.waitForDone();
 }
 
 /**
- * Initialize the data model.
+ * Initialize the data model before returning.
  * @throw qtouch::Exception
  */
 void DataModel::init()
 {
+	mDelivery = Qt::DirectConnection;
+	load();
+}
+
+/**
+ * Initialize the data model on a worker thread.
+ * Courses are inserted while they are parsed. Profiles are inserted and ready()
+ * is emitted when the database is in sync. Errors are reported by failed().
+ */
+void DataModel::initAsync()
+{
+	mDelivery = Qt::QueuedConnection;
+	mWorker.start(new InitTask(this));
+}
+
+/* Parse the changed course files, sync them into the database and read the profiles */
+void DataModel::load()
+{
+	TraceSpan loadSpan("DataModel::load");
+	WorkerConnectionGuard connectionGuard(mDb, mDelivery == Qt::QueuedConnection);
+
 	// Get all course files from the resources
-	QDir coursepath(QStringLiteral(":/courses"), "*.xml", QDir::Name | QDir::IgnoreCase, QDir::Files);
 	QStringList sourceFileList;
-	for (const auto& s : coursepath.entryList())
-		sourceFileList.append(coursepath.filePath(s));
+	{
+		TraceSpan span("enumerate course files");
+		QDir coursepath(QStringLiteral(":/courses"), "*.xml", QDir::Name | QDir::IgnoreCase, QDir::Files);
+		for (const auto& s : coursepath.entryList())
+			sourceFileList.append(coursepath.filePath(s));
+	}
+
+	// The schema check, every file, the course update and the profiles
+	const int total = sourceFileList.size() + 3;
+	int done = 0;
+	auto progress = [&](const QString& status)
+	{
+		QMetaObject::invokeMethod(this, "deliverProgress", mDelivery, Q_ARG(int, done), Q_ARG(int, total),
+		                          Q_ARG(QString, status));
+	};
+
+	progress(tr("Checking database"));
+
+	// Initialize the database
+	/* XXX: Use QStandardPaths::DataLocation when < 5.4
+	 * else QStandardPaths::AppDataLocation */
+
+	{
+		TraceSpan span("check database schema");
+
+		auto db = DbV1::create();
+		const int schemaVersion = db->VERSION;
+		mDb = std::move(db);
+		mDbHelper = std::unique_ptr<DbHelper>(new DbHelper(mDb, mDatabaseFile));
+
+		// Check database schema version
+		int dbVersion = mDbHelper->getShemaVersion();
+		if (dbVersion != schemaVersion)
+		{
+			bool migrated = false;
+			if (dbVersion > 0)
+			{
+				try
+				{
+					qDebug() << "Migrating database schema from version" << dbVersion << "to" << schemaVersion;
+					mDb->migrateSchema(dbVersion);
+					migrated = true;
+				}
+				catch (const DbException& e)
+				{
+					qWarning() << e.message();
+				}
+			}
+
+			if (!migrated)
+			{
+				// FIXME: Drop and recreate for now
+				mDb->dropSchema();
+				mDb->createSchema();
+			}
+		}
+	}
+	++done;
+
+	if (mCancel)
+		return;
+
+	// Read the hash of the build-in courses from the database
+	QByteArray dbHash = mDbHelper->getCourseHash();
+
+	// Compare the course files with the ones the database was built from
+	xml::Manifest manifest;
+	xml::Manifest dbManifest;
+	{
+		TraceSpan span("scan course manifest");
+		manifest = xml::Manifest::scan(sourceFileList);
+		dbManifest = xml::Manifest::fromByteArray(mDbHelper->getCourseManifest());
+	}
+
+	/* Warm start: Take the courses of unchanged files from the database.
+	 * Only trusted when the database still holds what the hash was built from. */
+	std::map<QUuid, std::shared_ptr<Course>> dbCourses;
+	if (!dbManifest.isEmpty() && !dbHash.isEmpty())
+	{
+		TraceSpan span("load stored courses");
+
+		std::vector<std::shared_ptr<Course>> stored;
+		if (mDbHelper->getCourses(Db::BuiltIn, std::inserter(stored, stored.begin()), true))
+		{
+			std::sort(stored.begin(), stored.end(), CourseListAscTitle());
+			if (hash(stored.begin(), stored.end()) == dbHash)
+			{
+				for (const auto& c : stored)
+					dbCourses[c->getId()] = c;
+			}
+			else
+			{
+				qDebug() << "Built-in courses in database differ from their hash: Parsing all course files.";
+			}
+		}
+	}
+
+	progress(tr("Loading courses"));
 
-	// Parse courses
 	std::vector<std::shared_ptr<Course>> parsedCourses;
 
 	xml::ParseResult result;
 	QString message;
 
-	// Create a validator
-	auto validator = xml::createValidator(QStringLiteral(":/courses/course.xsd"));
+	// Created on the first file that has to be parsed
+	std::unique_ptr<QXmlSchemaValidator> validator;
+	int parsed = 0;
 
-	// Parse Course files
-	QStringListIterator it(sourceFileList);
-	while (it.hasNext())
+	for (std::size_t i = 0; i < manifest.size(); ++i)
 	{
-		auto course = xml::parseCourse(it.next(), *validator, &result, &message);
-		if (result != xml::Ok)
+		if (mCancel)
+			return;
+
+		const xml::Manifest::Entry& entry = manifest.getEntries().at(i);
+		std::shared_ptr<Course> course;
+
+		auto dbCourse = dbCourses.find(dbManifest.unchangedCourse(entry));
+		if (dbCourse != dbCourses.end())
+		{
+			course = dbCourse->second;
+		}
+		else
 		{
-			qWarning() << "XML parser result:" << result << " " << message.toLatin1().data();
+			if (!validator)
+			{
+				TraceSpan span("create validator");
+				validator = xml::createValidator(QStringLiteral(":/courses/course.xsd"));
+			}
+
+			TraceSpan span("parse course", entry.file);
+			course = xml::parseCourse(entry.file, *validator, &result, &message);
+			if (result != xml::Ok)
+			{
+				qWarning() << "XML parser result:" << result << " " << message.toLatin1().data();
+			}
+			++parsed;
 		}
+		manifest.setCourseId(i, course->getId());
 		parsedCourses.push_back(course);
-	}
 
-	// Sorting
-	std::sort(parsedCourses.begin(), parsedCourses.end(), CourseListAscTitle());
-
-	// Calculate a hash
-	auto parsedHash = hash(parsedCourses.begin(), parsedCourses.end());
+		// Show the course right away. One delivery takes all pending courses.
+		bool first;
+		{
+			QMutexLocker lock(&mPendingMutex);
+			first = mPendingCourses.empty();
+			mPendingCourses.push_back(course);
+		}
+		if (first)
+			post("deliverCourses");
 
-	// Initialize the database
-	/* XXX: Use QStandardPaths::DataLocation when < 5.4
-	 * else QStandardPaths::AppDataLocation */
+		++done;
+		progress(tr("Loading courses"));
+	}
 
-	mDb = DbV1::create();
-	mDbHelper = std::unique_ptr<DbHelper>(new DbHelper(mDb, QStringLiteral("QTouch.sqlite")));
+	mParsedCount = parsed;
+	if (parsed)
+		qDebug() << "Parsed" << parsed << "of" << manifest.size() << "course files";
 
-	// Check database schema version
-	if (mDbHelper->getShemaVersion() != 1)
+	QByteArray parsedHash;
 	{
-		// FIXME: Drop and recreate for now
-		mDb->dropSchema();
-		mDb->createSchema();
-	}
+		TraceSpan span("sort and hash courses");
 
-	// Read the hash of the build-in courses from the database
-	QByteArray dbHash = mDbHelper->getCourseHash();
+		// Sorting
+		std::sort(parsedCourses.begin(), parsedCourses.end(), CourseListAscTitle());
+
+		// Calculate a hash
+		parsedHash = hash(parsedCourses.begin(), parsedCourses.end());
+	}
 
 	// Compare (On match, loading from Db is redundant)
-	if (parsedHash != dbHash)
+	bool synced = parsedHash == dbHash;
+	if (!synced)
 	{
 		qDebug() << "Built-in courses in database differ from courses files: Update needed.";
+		progress(tr("Updating courses"));
 
+		TraceSpan span("update built-in courses");
 		mDbHelper->updateBuiltinCourses(parsedCourses.begin(), parsedCourses.end());
 
-		if (parsedHash != mDbHelper->getCourseHash())
+		synced = parsedHash == mDbHelper->getCourseHash();
+		if (!synced)
 			qCritical() << "Hash mismatch after database update! Using course files";
 	}
 
-	mCourses = parsedCourses;
+	// Record the files the database is in sync with for the next start
+	if (synced && manifest != dbManifest)
+		mDbHelper->setCourseManifest(manifest.toByteArray());
+	++done;
+
+	progress(tr("Loading profiles"));
 
 	// Read profiles from Db; Stats are loaded on demand
-	mDbHelper->getProfiles(std::inserter(mProfiles, mProfiles.begin()));
+	std::vector<Profile> profiles;
+	{
+		TraceSpan span("load profiles");
+		mDbHelper->getProfiles(std::inserter(profiles, profiles.begin()));
+	}
+	{
+		QMutexLocker lock(&mPendingMutex);
+		mPendingProfiles = std::move(profiles);
+	}
+	++done;
+
+	// Before the model thread may use the database
+	connectionGuard.close();
+
+	post("deliverProfiles");
+	post("finish");
+}
+
+/* Call the given slot on the thread of the model */
+void DataModel::post(const char* method)
+{
+	QMetaObject::invokeMethod(this, method, mDelivery);
+}
+
+void DataModel::deliverProgress(int done, int total, const QString& status)
+{
+	mProgressDone = done;
+	mProgressTotal = total;
+	mStatus = status;
+	emit progressChanged();
+}
+
+/* Insert the pending courses at their sorted position */
+void DataModel::deliverCourses()
+{
+	std::vector<std::shared_ptr<Course>> courses;
+	{
+		QMutexLocker lock(&mPendingMutex);
+		courses.swap(mPendingCourses);
+	}
+
+	for (const auto& course : courses)
+	{
+		auto pos = std::upper_bound(mCourses.begin(), mCourses.end(), course, CourseListAscTitle());
+		int row = static_cast<int>(pos - mCourses.begin());
+
+		emit coursesAboutToBeInserted(row, row);
+		mCourses.insert(pos, course);
+		emit coursesInserted(row, row);
+	}
+}
+
+void DataModel::deliverProfiles()
+{
+	std::vector<Profile> profiles;
+	{
+		QMutexLocker lock(&mPendingMutex);
+		profiles.swap(mPendingProfiles);
+	}
+
+	if (profiles.empty())
+		return;
+
+	int first = static_cast<int>(mProfiles.size());
+	int last = first + static_cast<int>(profiles.size()) - 1;
+
+	emit profilesAboutToBeInserted(first, last);
+	mProfiles.insert(mProfiles.end(), profiles.begin(), profiles.end());
+	emit profilesInserted(first, last);
+}
+
+void DataModel::finish()
+{
+	mReady = true;
+	mStatus.clear();
+	emit progressChanged();
+	emit readyChanged();
+	emit ready();
+
+	// Remove Lessons that became unused by course updates in the background
+	QTimer::singleShot(0, this, &DataModel::collectLessons);
+}
+
+void DataModel::fail(const QString& message)
+{
+	mStatus = message;
+	emit progressChanged();
+	emit failed(message);
+}
+
+/* Run one batch of the Lesson garbage collection and reschedule until all candidates are processed. */
+void DataModel::collectLessons()
+{
+	bool pending = false;
+	int deleted = mDbHelper->collectDanglingLessons(LESSON_GC_BATCH_SIZE, &pending);
+	if (deleted < 0)
+		return;
+
+	if (deleted > 0)
+	{
+		mReclaimedLessons += deleted;
+		emit reclaimedLessonsChanged();
+	}
+
+	if (pending)
+		QTimer::singleShot(0, this, &DataModel::collectLessons);
+	else if (mReclaimedLessons > 0)
+		qInfo() << "Lesson garbage collection reclaimed" << mReclaimedLessons << "Lessons";
 }
 
 bool DataModel::isValidCourseIndex(int index) const
@@ -167,10 +484,15 @@ bool DataModel::isValidProfile(const QString& name) const
 bool DataModel::insertProfile(const Profile& profile)
 {
 	bool result = false;
-	if (!profile.getName().isEmpty() && !isValidProfile(profile.getName()) && mDbHelper->insert(profile))
+	// The database belongs to the worker until ready
+	if (mReady && !profile.getName().isEmpty() && !isValidProfile(profile.getName()) && mDbHelper->insert(profile))
 	{
 		result = true;
+
+		int row = static_cast<int>(mProfiles.size());
+		emit profilesAboutToBeInserted(row, row);
 		mProfiles.push_back(profile);
+		emit profilesInserted(row, row);
 	}
 	return result;
 }
@@ -179,8 +501,8 @@ Profile DataModel::getProfile(int index, bool selectStats)
 {
 	if (isValidProfileIndex(index))
 	{
-		// Lazy load stats
-		if (selectStats)
+		// Lazy load stats; the database belongs to the worker until ready
+		if (selectStats && mReady)
 		{
 			mProfiles.at(index).clear();
 			mDbHelper->getStats(mProfiles.at(index).getName(),
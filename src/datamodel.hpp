@@ -27,8 +27,11 @@
 #ifndef DATAMODEL_HPP_
 #define DATAMODEL_HPP_
 
+#include <atomic>
 #include <map>
 #include <QObject>
+#include <QMutex>
+#include <QThreadPool>
 
 #include "entities/course.hpp"
 #include "entities/profile.hpp"
@@ -39,15 +42,41 @@ namespace qtouch
 struct DbInterface;
 class DbHelper;
 
+/**
+ * Holds the courses and profiles.
+ * init() loads everything before it returns. initAsync() loads on a worker
+ * thread and inserts the courses as soon as they are parsed, so the UI can
+ * be shown right away. The database is owned by the worker until ready()
+ * is emitted.
+ */
 class DataModel: public QObject
 {
 	Q_OBJECT
 
+	Q_PROPERTY(bool ready READ isReady NOTIFY readyChanged)
+	Q_PROPERTY(qreal progress READ getProgress NOTIFY progressChanged)
+	Q_PROPERTY(QString status READ getStatus NOTIFY progressChanged)
+	Q_PROPERTY(int reclaimedLessons READ getReclaimedLessons NOTIFY reclaimedLessonsChanged)
+
 public:
 	explicit DataModel(QObject* parent = nullptr);
 	virtual ~DataModel();
 
+	/** The SQLite file the data is synced with. Set before the initialization. */
+	inline const QString& getDatabaseFile() const { return mDatabaseFile; }
+	inline void setDatabaseFile(const QString& fileName) { mDatabaseFile = fileName; }
+
 	void init();
+	void initAsync();
+
+	/** Number of course files the initialization parsed. The others were taken from the database. */
+	inline int getParsedCount() const { return mParsedCount; }
+
+	inline bool isReady() const { return mReady; }
+	inline qreal getProgress() const { return mProgressTotal ? qreal(mProgressDone) / mProgressTotal : 0; }
+	inline const QString& getStatus() const { return mStatus; }
+	/** Number of unused Lessons the garbage collection removed since the start. */
+	inline int getReclaimedLessons() const { return mReclaimedLessons; }
 
 	// Course
 
@@ -69,13 +98,61 @@ public:
 	Profile getProfile(int index, bool selectStats = false);
 	bool insertProfile(const Profile& profile);
 
+signals:
+	void progressChanged();
+	void readyChanged();
+	void ready();
+	void failed(const QString& message);
+	void reclaimedLessonsChanged();
+
+	/** Rows are inserted at the sorted position, so existing indexes may move. */
+	void coursesAboutToBeInserted(int first, int last);
+	void coursesInserted(int first, int last);
+	void profilesAboutToBeInserted(int first, int last);
+	void profilesInserted(int first, int last);
+
+private slots:
+	void collectLessons();
+
+	void deliverProgress(int done, int total, const QString& status);
+	void deliverCourses();
+	void deliverProfiles();
+	void finish();
+	void fail(const QString& message);
+
 private:
+	class InitTask;
+
+	void load();
+	void post(const char* method);
+
+	/* Parsed by the worker, inserted by deliverCourses() */
+	QMutex mPendingMutex;
+	std::vector<std::shared_ptr<Course>> mPendingCourses;
+	std::vector<Profile> mPendingProfiles;
+
+	/* Qt::QueuedConnection while loading on the worker */
+	Qt::ConnectionType mDelivery;
+	QThreadPool mWorker;
+	std::atomic<bool> mCancel;
+
+	bool mReady;
+	int mProgressDone;
+	int mProgressTotal;
+	QString mStatus;
+
 	std::shared_ptr<DbInterface> mDb;
 	std::unique_ptr<DbHelper> mDbHelper;
 
 	std::vector<std::shared_ptr<Course>> mCourses;
 	// TODO: Maybe better store as pointer!?
 	std::vector<Profile> mProfiles;
+
+	int mReclaimedLessons;
+
+	QString mDatabaseFile;
+	/* Written by the worker before ready() */
+	int mParsedCount;
 };
 
 } /* namespace qtouch */
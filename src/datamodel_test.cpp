@@ -24,9 +24,105 @@
  * \author Moritz Nisblé moritz.nisble@gmx.de
  */
 
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+
 #include "datamodel.hpp"
+#include "utils/exceptions.hpp"
 
 namespace qtouch
 {
 
+class DataModelTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+	void cleanup();
+
+	void coldStart();
+	void warmStart();
+
+private:
+	std::vector<std::shared_ptr<Course>> initModel(int* parsed);
+
+	std::unique_ptr<QTemporaryDir> mDir;
+};
+
+void DataModelTest::init()
+{
+	mDir.reset(new QTemporaryDir());
+	QVERIFY(mDir->isValid());
+}
+
+void DataModelTest::cleanup()
+{
+	mDir.reset();
+}
+
+/* Initialize a model on the temporary database and return its courses */
+std::vector<std::shared_ptr<Course>> DataModelTest::initModel(int* parsed)
+{
+	std::vector<std::shared_ptr<Course>> courses;
+
+	// The model owns the connection: Destroyed before the next one opens it
+	DataModel dm;
+	dm.setDatabaseFile(mDir->filePath(QStringLiteral("QTouch.sqlite")));
+
+	try
+	{
+		dm.init();
+	}
+	catch (const Exception& e)
+	{
+		qWarning() << e.message();
+		return courses;
+	}
+
+	if (!dm.isReady())
+		return courses;
+
+	for (int i = 0; i < dm.getCourseCount(); ++i)
+		courses.push_back(dm.getCourse(i));
+
+	*parsed = dm.getParsedCount();
+	return courses;
+}
+
+void DataModelTest::coldStart()
+{
+	int parsed = -1;
+	auto courses = initModel(&parsed);
+
+	QVERIFY(!courses.empty());
+	// Every course file was parsed
+	QCOMPARE(parsed, static_cast<int>(courses.size()));
+}
+
+void DataModelTest::warmStart()
+{
+	int coldParsed = -1;
+	auto cold = initModel(&coldParsed);
+	QVERIFY(!cold.empty());
+	QVERIFY(coldParsed > 0);
+
+	int warmParsed = -1;
+	auto warm = initModel(&warmParsed);
+
+	// All courses are taken from the database
+	QCOMPARE(warmParsed, 0);
+	QCOMPARE(warm.size(), cold.size());
+
+	for (std::size_t i = 0; i < cold.size(); ++i)
+	{
+		QCOMPARE(warm.at(i)->getId(), cold.at(i)->getId());
+		QCOMPARE(warm.at(i)->size(), cold.at(i)->size());
+	}
+	QCOMPARE(hash(warm.begin(), warm.end()), hash(cold.begin(), cold.end()));
+}
+
 } /* namespace qtouch */
+
+QTEST_GUILESS_MAIN(qtouch::DataModelTest)
+#include "datamodel_test.moc"
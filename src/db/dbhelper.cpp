@@ -83,6 +83,50 @@ QByteArray DbHelper::getCourseHash()
 	return hash;
 }
 
+/**
+ * Returns the manifest of the course files the built-in courses were updated from.
+ * @return The serialized manifest, empty if none was stored or on error.
+ */
+QByteArray DbHelper::getCourseManifest()
+{
+	QByteArray manifest;
+	try
+	{
+		if (!mDb->isOpen())
+			mDb->open(mPath);
+
+		manifest = mDb->getMeta(Db::metaCourseManifestKey).toByteArray();
+	}
+	catch (const DbException& e)
+	{
+		qCritical() << e.message();
+	}
+	return manifest;
+}
+
+/**
+ * Store the manifest of the course files. Should be called after the built-in
+ * courses were updated successfully.
+ * @param manifest The serialized manifest.
+ * @return true on success else false.
+ */
+bool DbHelper::setCourseManifest(const QByteArray& manifest)
+{
+	try
+	{
+		if (!mDb->isOpen())
+			mDb->open(mPath);
+
+		mDb->setMeta(Db::metaCourseManifestKey, manifest);
+	}
+	catch (const DbException& e)
+	{
+		qCritical() << e.message();
+		return false;
+	}
+	return true;
+}
+
 /**
  * Load a specific Course from the Database.
  * @param courseId A CourseId.
@@ -103,7 +147,7 @@ std::shared_ptr<Course> DbHelper::getCourse(const QUuid& courseId, bool includeL
 		if (query.next())
 		{
 			course = Course::create();
-			course->setId(QUuid(query.value("pkCourseUuid").toString()));
+			course->setId(mDb->toUuid(query.value("pkCourseUuid")));
 			course->setTitle(query.value("cCourseTitle").toString());
 			course->setDescription(query.value("cDescription").toString());
 			course->setBuiltin(query.value("cCourseBuiltin").toBool());
@@ -138,7 +182,7 @@ std::unique_ptr<Lesson> DbHelper::getLesson(const QUuid& lessonId)
 		if (query.next())
 		{
 			lesson.reset(new Lesson());
-			lesson->setId(QUuid(query.value("pkLessonUuid").toString()));
+			lesson->setId(mDb->toUuid(query.value("pkLessonUuid")));
 			lesson->setTitle(query.value("cLessonTitle").toString());
 			lesson->setNewChars(query.value("cNewChars").toString());
 			lesson->setBuiltin(query.value("cLessonBuiltin").toBool());
@@ -170,7 +214,7 @@ bool DbHelper::loadLessons(Course& course)
 		while (query.next())
 		{
 			Lesson lesson;
-			lesson.setId(QUuid(query.value("pkLessonUuid").toString()));
+			lesson.setId(mDb->toUuid(query.value("pkLessonUuid")));
 			lesson.setTitle(query.value("cLessonTitle").toString());
 			lesson.setNewChars(query.value("cNewChars").toString());
 			lesson.setBuiltin(query.value("cLessonBuiltin").toBool());
@@ -305,6 +349,38 @@ bool DbHelper::deleteLesson(const QUuid& lessonId)
 	return true;
 }
 
+/**
+ * Run one bounded step of the Lesson garbage collection.
+ * Built-in Lessons that are not used by any Course anymore are deleted.
+ * @param limit The maximum number of candidates to check.
+ * @param pending Optional output, true if candidates are left.
+ * @return The number of deleted Lessons or -1 on failure.
+ */
+int DbHelper::collectDanglingLessons(int limit, bool* pending)
+{
+	int deleted = 0;
+	try
+	{
+		if (!mDb->isOpen())
+			mDb->open(mPath);
+
+		mDb->begin_transaction();
+
+		deleted = mDb->deleteDanglingLessons(limit);
+		if (pending)
+			*pending = mDb->hasLessonGcCandidates();
+
+		mDb->end_transaction();
+	}
+	catch (const DbException& e)
+	{
+		mDb->rollback();
+		qCritical() << e.message();
+		return -1;
+	}
+	return deleted;
+}
+
 /* Private Course manipulation helper.
  * This functions should be called from inside transactions. */
 void DbHelper::insertCourseHelper(const Course& course)
@@ -50,12 +50,16 @@ public:
 
 	int getShemaVersion();
 	QByteArray getCourseHash();
+	QByteArray getCourseManifest();
+	bool setCourseManifest(const QByteArray& manifest);
 
 	template<typename OutputIter>
 	bool getProfiles(OutputIter out);
 	template<typename OutputIter>
 	bool getStats(const QString& profileName, OutputIter out);
 	template<typename OutputIter>
+	bool getStats(const QString& profileName, const QDateTime& from, const QDateTime& to, OutputIter out);
+	template<typename OutputIter>
 	bool getCourses(Db::CourseType type, OutputIter out, bool includeLessons = false);
 	std::shared_ptr<Course> getCourse(const QUuid& courseId, bool includeLessons = false);
 	std::unique_ptr<Lesson> getLesson(const QUuid& lessonId);
@@ -79,7 +83,12 @@ public:
 	bool deleteCourse(const QUuid& courseId);
 	bool deleteLesson(const QUuid& lessonId);
 
+	int collectDanglingLessons(int limit, bool* pending = nullptr);
+
 private:
+	template<typename OutputIter>
+	void readStats(QSqlQuery& query, const QString& profileName, OutputIter out);
+
 	void insertCourseHelper(const Course& course);
 	void updateCourseHelper(const Course& course);
 
@@ -124,19 +133,40 @@ inline bool qtouch::DbHelper::getStats(const QString& profileName, OutputIter ou
 		if (!mDb->isOpen())
 			mDb->open(mPath);
 
-		// pkfkLessonUuid, pkStartDateTime, cTime, cCharCount, cErrorCount
+		// pkCourseUuid, pkLessonUuid, pkStartDateTime, cTime, cCharCount, cErrorCount
 		auto query = mDb->selectStats(profileName);
+		readStats(query, profileName, out);
+	}
+	catch (const DbException& e)
+	{
+		qCritical() << e.message();
+		return false;
+	}
 
-		while (query.next())
-		{
-			Stats stats(query.value("pkCourseUuid").toUuid(), query.value("pkLessonUuid").toUuid(), profileName, query.value("pkStartDateTime").toDateTime());
-			stats.setTime(query.value("cTime").toUInt());
-			stats.setCharCount(query.value("cCharCount").toUInt());
-			stats.setErrorCount(query.value("cErrorCount").toUInt());
+	return true;
+}
 
-			*out = stats;
-			++out;
-		}
+/**
+ * Load the Stats of a profile that were started in the given time range.
+ * E.g. the last 7 days: getStats(name, QDateTime::currentDateTime().addDays(-7), QDateTime::currentDateTime(), out)
+ * @param profileName A ProfileName.
+ * @param from Start of the range (inclusive).
+ * @param to End of the range (exclusive).
+ * @param out An output iterator that takes the Stats ordered by start time.
+ * @return true on success else false.
+ */
+template<typename OutputIter>
+inline bool qtouch::DbHelper::getStats(const QString& profileName, const QDateTime& from, const QDateTime& to,
+                                       OutputIter out)
+{
+	try
+	{
+		if (!mDb->isOpen())
+			mDb->open(mPath);
+
+		// pkCourseUuid, pkLessonUuid, pkStartDateTime, cTime, cCharCount, cErrorCount
+		auto query = mDb->selectStats(profileName, from, to);
+		readStats(query, profileName, out);
 	}
 	catch (const DbException& e)
 	{
@@ -147,6 +177,22 @@ inline bool qtouch::DbHelper::getStats(const QString& profileName, OutputIter ou
 	return true;
 }
 
+template<typename OutputIter>
+inline void qtouch::DbHelper::readStats(QSqlQuery& query, const QString& profileName, OutputIter out)
+{
+	while (query.next())
+	{
+		Stats stats(mDb->toUuid(query.value("pkCourseUuid")), mDb->toUuid(query.value("pkLessonUuid")), profileName,
+		            mDb->toDateTime(query.value("pkStartDateTime")));
+		stats.setTime(query.value("cTime").toUInt());
+		stats.setCharCount(query.value("cCharCount").toUInt());
+		stats.setErrorCount(query.value("cErrorCount").toUInt());
+
+		*out = stats;
+		++out;
+	}
+}
+
 template<typename OutputIter>
 bool DbHelper::getCourses(Db::CourseType type, OutputIter out, bool includeLessons)
 {
@@ -161,7 +207,7 @@ bool DbHelper::getCourses(Db::CourseType type, OutputIter out, bool includeLesso
 		while (query.next())
 		{
 			auto course = Course::create();
-			course->setId(QUuid(query.value("pkCourseUuid").toString()));
+			course->setId(mDb->toUuid(query.value("pkCourseUuid")));
 			course->setTitle(query.value("cCourseTitle").toString());
 			course->setDescription(query.value("cDescription").toString());
 			course->setBuiltin(query.value("cCourseBuiltin").toBool());
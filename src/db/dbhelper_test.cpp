@@ -49,6 +49,7 @@ private slots:
 	void cleanup();
 
 	void insertCourseTest();
+	void collectDanglingLessonsTest();
 
 private:
 	void reset();
@@ -141,6 +142,75 @@ void DbHelperTest::insertCourseTest()
 	reset();
 }
 
+void DbHelperTest::collectDanglingLessonsTest()
+{
+	reset();
+
+	auto createLesson = [](const QString& title, bool builtin)
+	{
+		Lesson lesson;
+		lesson.setId(QUuid());
+		lesson.setTitle(title);
+		lesson.setText(title);
+		lesson.setBuiltin(builtin);
+		return lesson;
+	};
+
+	Lesson l1 = createLesson("Lesson 1", true);
+	Lesson l2 = createLesson("Lesson 2", true);
+	Lesson l3 = createLesson("Lesson 3", true);
+	Lesson custom = createLesson("Custom Lesson", false);
+
+	auto c1 = Course::create();
+	c1->setId(QUuid());
+	c1->setTitle("Course 1");
+	c1->setBuiltin(true);
+	c1->push_back(l1);
+	c1->push_back(l2);
+	c1->push_back(l3);
+	c1->push_back(custom);
+
+	// Lesson 2 is shared with a second course
+	auto c2 = Course::create();
+	c2->setId(QUuid());
+	c2->setTitle("Course 2");
+	c2->setBuiltin(true);
+	c2->push_back(l2);
+
+	QVERIFY(mDbHelper->insert(*c1));
+	QVERIFY(mDbHelper->insert(*c2));
+
+	// Nothing to collect yet
+	bool pending = true;
+	QCOMPARE(mDbHelper->collectDanglingLessons(10, &pending), 0);
+	QCOMPARE(pending, false);
+
+	// Deleting the course makes all of its lessons candidates
+	QVERIFY(mDbHelper->deleteCourse(c1->getId()));
+
+	// Collect in batches of one
+	int deleted = 0;
+	int batches = 0;
+	do
+	{
+		int d = mDbHelper->collectDanglingLessons(1, &pending);
+		QVERIFY(d >= 0);
+		deleted += d;
+		++batches;
+	}
+	while (pending);
+
+	QCOMPARE(batches, 4);
+	QCOMPARE(deleted, 2);
+
+	QVERIFY(!mDbHelper->getLesson(l1.getId()));
+	QVERIFY(!mDbHelper->getLesson(l3.getId()));
+	// Still used by Course 2
+	QVERIFY(mDbHelper->getLesson(l2.getId()) != nullptr);
+	// Custom lessons are kept
+	QVERIFY(mDbHelper->getLesson(custom.getId()) != nullptr);
+}
+
 } /* namespace qtouch */
 
 QTEST_GUILESS_MAIN(qtouch::DbHelperTest)
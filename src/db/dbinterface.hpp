@@ -42,6 +42,7 @@ enum CourseType { All, BuiltIn, Custom };
 
 const QString metaSchemaVersionKey = QStringLiteral("SchemaVersion");
 const QString metaCourseHashKey = QStringLiteral("BuiltInCourseHash");
+const QString metaCourseManifestKey = QStringLiteral("BuiltInCourseManifest");
 } /* namespace Db */
 
 struct DbInterface
@@ -54,6 +55,12 @@ struct DbInterface
 	/* Schema */
 	virtual void createSchema() = 0;
 	virtual void dropSchema() = 0;
+	virtual void migrateSchema(int fromVersion) = 0;
+
+	/* Convert a UUID column of a selected row back into a QUuid */
+	virtual QUuid toUuid(const QVariant& column) const = 0;
+	/* Convert a DateTime column of a selected row back into a QDateTime */
+	virtual QDateTime toDateTime(const QVariant& column) const = 0;
 
 	/* MetaTable */
 	virtual void setMeta(const QString& key, const QVariant& value) = 0;
@@ -80,6 +87,7 @@ struct DbInterface
 	/* SELECT */
 	virtual QSqlQuery selectProfiles() = 0;
 	virtual QSqlQuery selectStats(const QString& profileName) = 0;
+	virtual QSqlQuery selectStats(const QString& profileName, const QDateTime& from, const QDateTime& to) = 0;
 	virtual QSqlQuery selectCourses(Db::CourseType type) = 0;
 	virtual QSqlQuery selectCourse(const QUuid& courseId) = 0;
 	virtual QSqlQuery selectLesson(const QUuid& lessonId) = 0;
@@ -93,6 +101,10 @@ struct DbInterface
 	virtual void deleteLesson(const QUuid& lessonId) = 0;
 	virtual void deleteLessonList(const QUuid& courseId) = 0;
 
+	/* Garbage collection of Lessons. Candidates are tracked on deletion of LessonList entries. */
+	virtual int deleteDanglingLessons(int limit) = 0;
+	virtual bool hasLessonGcCandidates() = 0;
+
 	virtual ~DbInterface() {}
 };
 
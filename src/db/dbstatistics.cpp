@@ -0,0 +1,168 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file dbstatistics.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "dbstatistics.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <QTextStream>
+#include <QStringBuilder>
+
+#include "utils/diagnostics.hpp"
+
+namespace qtouch
+{
+
+namespace
+{
+
+const int MAX_STATEMENT_LENGTH = 100;
+
+QString formatLine(const DbStatistics::Entry& e, const QString& name)
+{
+	return QString("%1 %2 %3 %4 %5 %6 %7  %8")
+	       .arg(e.count, 8)
+	       .arg(e.rows, 8)
+	       .arg(e.totalNs / 1e6, 10, 'f', 2)
+	       .arg(e.count ? e.totalNs / e.count / 1000 : 0, 9)
+	       .arg(e.percentile(0.5) / 1000, 9)
+	       .arg(e.percentile(0.95) / 1000, 9)
+	       .arg(e.maxNs / 1000, 9)
+	       .arg(name);
+}
+
+} /* namespace */
+
+const int DbStatistics::BUCKETS;
+const char* DbStatistics::ENV_VAR = "QTOUCH_DB_STATS";
+
+/**
+ * Check if the statistics are enabled by setting QTOUCH_DB_STATS to a value other than 0.
+ * @return true if enabled.
+ */
+bool DbStatistics::enabledByEnvironment()
+{
+	return diagnostics::isEnabled(ENV_VAR);
+}
+
+int DbStatistics::bucket(qint64 ns)
+{
+	qint64 us = ns / 1000;
+	int b = 0;
+	while (b < BUCKETS - 1 && us >= (qint64(1) << b))
+		++b;
+	return b;
+}
+
+void DbStatistics::Entry::add(qint64 ns, int rows)
+{
+	++count;
+	if (rows > 0)
+		this->rows += rows;
+	totalNs += ns;
+	maxNs = std::max(maxNs, ns);
+	++histogram[bucket(ns)];
+}
+
+/**
+ * Estimate a percentile from the histogram.
+ * @param p The percentile in the range [0,1].
+ * @return The upper bound of the bucket that contains the percentile in ns,
+ * limited to the maximum latency.
+ */
+qint64 DbStatistics::Entry::percentile(double p) const
+{
+	if (!count)
+		return 0;
+
+	quint64 rank = std::max<quint64>(1, static_cast<quint64>(p * count + 0.5));
+	quint64 sum = 0;
+	for (int b = 0; b < BUCKETS; ++b)
+	{
+		sum += histogram[b];
+		if (sum >= rank)
+			return std::min(maxNs, (qint64(1) << b) * 1000);
+	}
+	return maxNs;
+}
+
+void DbStatistics::addStatement(const QString& statement, qint64 ns, int rows)
+{
+	mStatements[statement].add(ns, rows);
+}
+
+void DbStatistics::addTransaction(qint64 ns, bool committed)
+{
+	(committed ? mCommits : mRollbacks).add(ns, 0);
+}
+
+void DbStatistics::clear()
+{
+	mStatements.clear();
+	mCommits = Entry();
+	mRollbacks = Entry();
+}
+
+/**
+ * Format the statistics as a table. Statements are sorted by their total time.
+ * Times are given in us unless noted otherwise.
+ * @return The table.
+ */
+QString DbStatistics::dump() const
+{
+	QString out;
+	QTextStream s(&out);
+
+	s << "Database statistics:\n";
+	s << QString("%1 %2 %3 %4 %5 %6 %7  %8\n")
+	  .arg("count", 8).arg("rows", 8).arg("total ms", 10).arg("mean", 9)
+	  .arg("p50", 9).arg("p95", 9).arg("max", 9).arg("statement");
+
+	std::vector<std::map<QString, Entry>::const_iterator> sorted;
+	for (auto it = mStatements.cbegin(); it != mStatements.cend(); ++it)
+		sorted.push_back(it);
+	std::sort(sorted.begin(), sorted.end(), [](const std::map<QString, Entry>::const_iterator& lhs,
+	          const std::map<QString, Entry>::const_iterator& rhs)
+	{
+		return lhs->second.totalNs > rhs->second.totalNs;
+	});
+
+	for (const auto& it : sorted)
+	{
+		QString statement = it->first.simplified();
+		if (statement.size() > MAX_STATEMENT_LENGTH)
+			statement = statement.left(MAX_STATEMENT_LENGTH - 3) % "...";
+		s << formatLine(it->second, statement) << "\n";
+	}
+
+	s << formatLine(mCommits, QStringLiteral("<commit>")) << "\n";
+	s << formatLine(mRollbacks, QStringLiteral("<rollback>")) << "\n";
+
+	s.flush();
+	return out;
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,87 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file dbstatistics.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef DBSTATISTICS_HPP_
+#define DBSTATISTICS_HPP_
+
+#include <array>
+#include <map>
+#include <QString>
+
+namespace qtouch
+{
+
+/**
+ * Collects latency and row counts of executed statements and the duration of transactions.
+ * Statements are identified by their SQL text.
+ * The latencies are collected in a histogram with power of two buckets in microseconds.
+ */
+class DbStatistics
+{
+public:
+	/** Bucket i counts latencies < 2^i us, the last one counts everything above. */
+	static const int BUCKETS = 20;
+
+	struct Entry
+	{
+		Entry() : count(0), rows(0), totalNs(0), maxNs(0) { histogram.fill(0); }
+
+		quint64 count;
+		quint64 rows;
+		qint64 totalNs;
+		qint64 maxNs;
+		std::array<quint32, BUCKETS> histogram;
+
+		void add(qint64 ns, int rows);
+		qint64 percentile(double p) const;
+	};
+
+	/** Name of the environment variable that enables the statistics.
+	 * DbV1 reports them on destruction, see diagnostics::report(). */
+	static const char* ENV_VAR;
+	static bool enabledByEnvironment();
+
+	static int bucket(qint64 ns);
+
+	void addStatement(const QString& statement, qint64 ns, int rows);
+	void addTransaction(qint64 ns, bool committed);
+	void clear();
+
+	inline const std::map<QString, Entry>& getStatements() const { return mStatements; }
+	inline const Entry& getCommits() const { return mCommits; }
+	inline const Entry& getRollbacks() const { return mRollbacks; }
+
+	QString dump() const;
+
+private:
+	std::map<QString, Entry> mStatements;
+	Entry mCommits;
+	Entry mRollbacks;
+};
+
+} /* namespace qtouch */
+
+#endif /* DBSTATISTICS_HPP_ */
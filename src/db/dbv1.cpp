@@ -28,10 +28,13 @@
 
 #include <QFileInfo>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QtSql/QSqlDatabase>
 
 #include <QDebug>
 
+#include "utils/diagnostics.hpp"
+
 namespace qtouch
 {
 
@@ -51,7 +54,7 @@ const QString create_tblProfile = QStringLiteral("CREATE TABLE IF NOT EXISTS tbl
                                   " ) WITHOUT ROWID;");
 
 const QString create_tblLesson = QStringLiteral("CREATE TABLE IF NOT EXISTS tblLesson (\n"
-                                 "	pkLessonUuid		TEXT NOT NULL PRIMARY KEY,\n"
+                                 "	pkLessonUuid		BLOB NOT NULL PRIMARY KEY,\n"
                                  "	cLessonTitle		TEXT NOT NULL,\n"
                                  "	cNewChars			TEXT,\n"
                                  "	cLessonBuiltin		NUMERIC NOT NULL DEFAULT 0,\n"
@@ -59,7 +62,7 @@ const QString create_tblLesson = QStringLiteral("CREATE TABLE IF NOT EXISTS tblL
                                  ") WITHOUT ROWID;");
 
 const QString create_tblCourse = QStringLiteral("CREATE TABLE IF NOT EXISTS tblCourse (\n"
-                                 "	pkCourseUuid		TEXT NOT NULL PRIMARY KEY,\n"
+                                 "	pkCourseUuid		BLOB NOT NULL PRIMARY KEY,\n"
                                  "	cCourseTitle		TEXT NOT NULL,\n"
                                  "	cDescription		TEXT,\n"
                                  "	cCourseBuiltin		NUMERIC NOT NULL DEFAULT 0\n"
@@ -67,8 +70,8 @@ const QString create_tblCourse = QStringLiteral("CREATE TABLE IF NOT EXISTS tblC
 
 const QString create_tblLessonList = QStringLiteral("CREATE TABLE IF NOT EXISTS tblLessonList (\n"
                                      "	pkLessonListId		INTEGER PRIMARY KEY AUTOINCREMENT,\n"
-                                     "	fkCourseUuid		TEXT REFERENCES tblCourse(pkCourseUuid) ON UPDATE CASCADE ON DELETE CASCADE,\n"
-                                     "	fkLessonUuid		TEXT NOT NULL REFERENCES tblLesson(pkLessonUuid) ON UPDATE CASCADE ON DELETE CASCADE,\n"
+                                     "	fkCourseUuid		BLOB REFERENCES tblCourse(pkCourseUuid) ON UPDATE CASCADE ON DELETE CASCADE,\n"
+                                     "	fkLessonUuid		BLOB NOT NULL REFERENCES tblLesson(pkLessonUuid) ON UPDATE CASCADE ON DELETE CASCADE,\n"
                                      "	-- List handling\n"
                                      "	fkParentId			INTEGER DEFAULT NULL REFERENCES tblLessonList(pkLessonListId),\n"
                                      "	fkChildId			INTEGER DEFAULT NULL REFERENCES tblLessonList(pkLessonListId),\n"
@@ -78,10 +81,11 @@ const QString create_tblLessonList = QStringLiteral("CREATE TABLE IF NOT EXISTS
 const QString create_LessonListBeforeInsert =
     QStringLiteral("CREATE TRIGGER IF NOT EXISTS LessonListBeforeInsert BEFORE INSERT ON tblLessonList\n"
                    "BEGIN\n"
-                   "	SELECT RAISE(ABORT, \'LessonList constraint failed: List head lacks course\') FROM tblLessonList\n"
+                   "	-- No FROM clause: The checks must not loop over the list\n"
+                   "	SELECT RAISE(ABORT, \'LessonList constraint failed: List head lacks course\')\n"
                    "		WHERE NEW.fkParentId ISNULL AND (SELECT pkCourseUuid FROM tblCourse WHERE pkCourseUuid = NEW.fkCourseUuid) ISNULL;\n"
                    "\n"
-                   "	SELECT RAISE(ABORT, \'LessonList constraint failed: Wrong course ID\') FROM tblLessonList\n"
+                   "	SELECT RAISE(ABORT, \'LessonList constraint failed: Wrong course ID\')\n"
                    "		WHERE NEW.fkParentId NOTNULL AND (SELECT fkCourseUuid FROM tblLessonList WHERE pkLessonListId = NEW.fkParentId) != NEW.fkCourseUuid;\n"
                    "END;");
 
@@ -131,6 +135,18 @@ const QString create_LessonListBeforeDelete =
                    "	UPDATE tblLessonList SET fkParentId = OLD.fkParentId WHERE pkLessonListId = OLD.fkChildId;\n"
                    "END;");
 
+/* Each Lesson that loses a LessonList entry becomes a candidate for the garbage collection.
+ * This avoids searching the whole Lesson table for dangling Lessons. */
+const QString create_tblLessonGc = QStringLiteral("CREATE TABLE IF NOT EXISTS tblLessonGc (\n"
+                                   "	pkLessonUuid		BLOB NOT NULL PRIMARY KEY\n"
+                                   ") WITHOUT ROWID;");
+
+const QString create_LessonListAfterDelete =
+    QStringLiteral("CREATE TRIGGER IF NOT EXISTS LessonListAfterDelete AFTER DELETE ON tblLessonList\n"
+                   "BEGIN\n"
+                   "	INSERT OR IGNORE INTO tblLessonGc VALUES (OLD.fkLessonUuid);\n"
+                   "END;");
+
 const QString create_vDanglingLessons = QStringLiteral("CREATE VIEW IF NOT EXISTS vDanglingLessons AS\n"
                                         "SELECT pkLessonUuid FROM tblLesson WHERE pkLessonUuid NOT IN  (SELECT fkLessonUuid FROM tblLessonList);");
 
@@ -165,13 +181,21 @@ const QString create_vLessons = QStringLiteral("CREATE VIEW IF NOT EXISTS vLesso
 const QString create_tblStats = QStringLiteral("CREATE TABLE IF NOT EXISTS tblStats (\n"
                                 "	pkfkLessonListId	INTEGER NOT NULL REFERENCES tblLessonList(pkLessonListId) ON UPDATE CASCADE ON DELETE CASCADE,\n"
                                 "	pkfkProfileName		TEXT NOT NULL REFERENCES tblProfile(pkProfileName) ON UPDATE CASCADE ON DELETE CASCADE,\n"
-                                "	pkStartDateTime		TEXT NOT NULL,\n"
+                                "	pkStartDateTime		INTEGER NOT NULL,\n"
                                 "	cTime				INTEGER NOT NULL,\n"
                                 "	cCharCount			INTEGER NOT NULL,\n"
                                 "	cErrorCount			INTEGER,\n"
                                 "	PRIMARY KEY(pkfkLessonListId, pkfkProfileName, pkStartDateTime)\n"
                                 ") WITHOUT ROWID;");
 
+const QString create_idxStatsProfileStart = QStringLiteral("CREATE INDEX IF NOT EXISTS idxStatsProfileStart ON tblStats(pkfkProfileName, pkStartDateTime);");
+
+/* Indexes for the list pointers and the lesson reference. Used by the LessonList triggers
+ * and the foreign key actions on deletion. */
+const QString create_idxLessonListParent = QStringLiteral("CREATE INDEX IF NOT EXISTS idxLessonListParent ON tblLessonList(fkParentId);");
+const QString create_idxLessonListChild = QStringLiteral("CREATE INDEX IF NOT EXISTS idxLessonListChild ON tblLessonList(fkChildId);");
+const QString create_idxLessonListLesson = QStringLiteral("CREATE INDEX IF NOT EXISTS idxLessonListLesson ON tblLessonList(fkLessonUuid);");
+
 inline QString lastQuery(const QSqlQuery& query)
 {
 	QString str = query.lastQuery();
@@ -196,15 +220,143 @@ inline void exec_query_string(QSqlQuery& q, const QString& str)
 		throw DbException(QStringLiteral("Query failed: ") % lastQuery(q), q.lastError());
 }
 
+/* Tables, views and triggers are split up to allow the schema migration
+ * to fill the tables before the triggers are installed. */
+void create_tables(QSqlQuery& q)
+{
+	exec_query_string(q, create_tblMeta);
+	exec_query_string(q, create_tblProfile);
+	exec_query_string(q, create_tblLesson);
+	exec_query_string(q, create_tblCourse);
+	exec_query_string(q, create_tblLessonList);
+	exec_query_string(q, create_tblStats);
+	exec_query_string(q, create_tblLessonGc);
+
+	exec_query_string(q, create_idxStatsProfileStart);
+	exec_query_string(q, create_idxLessonListParent);
+	exec_query_string(q, create_idxLessonListChild);
+	exec_query_string(q, create_idxLessonListLesson);
+}
+
+void drop_indexes(QSqlQuery& q)
+{
+	exec_query_string(q, "DROP INDEX IF EXISTS idxLessonListLesson");
+	exec_query_string(q, "DROP INDEX IF EXISTS idxLessonListChild");
+	exec_query_string(q, "DROP INDEX IF EXISTS idxLessonListParent");
+	exec_query_string(q, "DROP INDEX IF EXISTS idxStatsProfileStart");
+}
+
+void create_views_and_triggers(QSqlQuery& q)
+{
+	exec_query_string(q, create_vDanglingLessons);
+	exec_query_string(q, create_vLessonListForward);
+	exec_query_string(q, create_vLessons);
+
+	exec_query_string(q, create_LessonListBeforeInsert);
+	exec_query_string(q, create_LessonListAfterInsert);
+	exec_query_string(q, create_LessonListAfterInsertHead);
+	exec_query_string(q, create_LessonListBeforeChildIdUpdate);
+	exec_query_string(q, create_LessonListBeforeDelete);
+	exec_query_string(q, create_LessonListAfterDelete);
+}
+
+void drop_views_and_triggers(QSqlQuery& q)
+{
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListAfterDelete");
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeDelete");
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeChildIdUpdate");
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListAfterInsertHead");
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListAfterInsert");
+	exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeInsert");
+
+	exec_query_string(q, "DROP VIEW IF EXISTS vLessons");
+	exec_query_string(q, "DROP VIEW IF EXISTS vLessonListForward");
+	exec_query_string(q, "DROP VIEW IF EXISTS vDanglingLessons");
+}
+
 } /* namespace */
 
 std::unique_ptr<DbV1> DbV1::create()
 {
-	return std::unique_ptr<DbV1>(new DbV1);
+	std::unique_ptr<DbV1> db(new DbV1);
+	db->setStatisticsEnabled(DbStatistics::enabledByEnvironment());
+	return db;
+}
+
+/**
+ * Enable or disable the collection of statement statistics.
+ * Disabling discards the collected statistics.
+ * @param enabled true to enable.
+ */
+void DbV1::setStatisticsEnabled(bool enabled)
+{
+	if (enabled && !mStatistics)
+		mStatistics.reset(new DbStatistics);
+	else if (!enabled)
+		mStatistics.reset();
+}
+
+/**
+ * Encode a UUID into its 16 byte binary form (RFC 4122) that is stored in BLOB columns.
+ * @param uuid A UUID.
+ * @return The binary UUID.
+ */
+QByteArray DbV1::encodeUuid(const QUuid& uuid)
+{
+	return uuid.toRfc4122();
+}
+
+/**
+ * Decode a UUID column.
+ * Columns of databases that were not migrated yet may still contain the
+ * textual form ("{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}"), which is accepted too.
+ * @param column The value of a UUID column.
+ * @return The UUID or a null UUID if the column doesn't contain one.
+ */
+QUuid DbV1::decodeUuid(const QVariant& column)
+{
+	if (column.type() == QVariant::ByteArray)
+	{
+		QByteArray bytes = column.toByteArray();
+		if (bytes.size() == 16)
+			return QUuid::fromRfc4122(bytes);
+	}
+	return QUuid(column.toString());
+}
+
+/**
+ * Encode a point in time into milliseconds since the epoch (UTC).
+ * The stored value is independent of the time zone the stats were recorded in.
+ * @param dateTime A QDateTime in any time spec.
+ * @return Milliseconds since 1970-01-01T00:00:00 UTC.
+ */
+qint64 DbV1::encodeDateTime(const QDateTime& dateTime)
+{
+	return dateTime.toMSecsSinceEpoch();
+}
+
+/**
+ * Decode a DateTime column into local time.
+ * Columns of databases that were not migrated yet may still contain
+ * ISO 8601 strings, which are accepted too. Strings without offset are
+ * interpreted as local time, like they were written.
+ * @param column The value of a DateTime column.
+ * @return The QDateTime in local time or an invalid QDateTime.
+ */
+QDateTime DbV1::decodeDateTime(const QVariant& column)
+{
+	if (column.type() == QVariant::LongLong || column.type() == QVariant::Int)
+		return QDateTime::fromMSecsSinceEpoch(column.toLongLong());
+
+	return QDateTime::fromString(column.toString(), Qt::ISODate).toLocalTime();
 }
 
 DbV1::~DbV1()
 {
+	// Once at shutdown, the connection is closed and reopened during startup
+	if (mStatistics)
+		diagnostics::report(DbStatistics::ENV_VAR, mStatistics->dump());
+
 	close();
 }
 
@@ -270,22 +422,8 @@ void DbV1::createSchema()
 		exec_query_string(q, pragma_user_version);
 		exec_query_string(q, QStringLiteral("PRAGMA foreign_keys = true"));
 
-		exec_query_string(q, create_tblMeta);
-		exec_query_string(q, create_tblProfile);
-		exec_query_string(q, create_tblLesson);
-		exec_query_string(q, create_tblCourse);
-		exec_query_string(q, create_tblLessonList);
-		exec_query_string(q, create_tblStats);
-
-		exec_query_string(q, create_vDanglingLessons);
-		exec_query_string(q, create_vLessonListForward);
-		exec_query_string(q, create_vLessons);
-
-		exec_query_string(q, create_LessonListBeforeInsert);
-		exec_query_string(q, create_LessonListAfterInsert);
-		exec_query_string(q, create_LessonListAfterInsertHead);
-		exec_query_string(q, create_LessonListBeforeChildIdUpdate);
-		exec_query_string(q, create_LessonListBeforeDelete);
+		create_tables(q);
+		create_views_and_triggers(q);
 
 		setMeta(Db::metaSchemaVersionKey, VERSION);
 
@@ -310,16 +448,11 @@ void DbV1::dropSchema()
 
 	try
 	{
-		exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeDelete");
-		exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeChildIdUpdate");
-		exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListAfterInsertHead");
-		exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListAfterInsert");
-		exec_query_string(q, "DROP TRIGGER IF EXISTS LessonListBeforeInsert");
+		drop_views_and_triggers(q);
 
-		exec_query_string(q, "DROP VIEW IF EXISTS vLessons");
-		exec_query_string(q, "DROP VIEW IF EXISTS vLessonListForward");
-		exec_query_string(q, "DROP VIEW IF EXISTS vDanglingLessons");
+		drop_indexes(q);
 
+		exec_query_string(q, "DROP TABLE IF EXISTS tblLessonGc");
 		exec_query_string(q, "DROP TABLE IF EXISTS tblStats");
 		exec_query_string(q, "DROP TABLE IF EXISTS tblLessonList");
 		exec_query_string(q, "DROP TABLE IF EXISTS tblCourse");
@@ -337,6 +470,213 @@ void DbV1::dropSchema()
 	}
 }
 
+/**
+ * Migrate the schema of an existing database to the current version.
+ * Version 1 stored the UUIDs as text. Version 2 stores them as 16 byte BLOBs.
+ * Version 3 stores the start of the stats as milliseconds since the epoch.
+ * Version 4 adds indexes for the LessonList pointers and lesson references.
+ * Version 5 adds the tracking of garbage collection candidates. All dangling lessons
+ * are added as candidates once.
+ * Version 6 removes the list scan from the LessonList insert checks.
+ * The content of all tables is preserved. Since SQLite cannot decode the textual
+ * UUIDs and DateTimes, the affected rows are copied over by the application.
+ * @param fromVersion The schema version of the opened database.
+ * @throw DbException when the version is unknown or the migration failed.
+ */
+void DbV1::migrateSchema(int fromVersion)
+{
+	checkOpen();
+
+	if (fromVersion == VERSION)
+		return;
+
+	if (fromVersion < 1 || fromVersion > VERSION)
+		throw DbException(QStringLiteral("Unable to migrate schema version ") % QString::number(fromVersion));
+
+	QSqlQuery q(*db);
+	q.setForwardOnly(true);
+
+	// Foreign key enforcement cannot be changed inside a transaction
+	exec_query_string(q, QStringLiteral("PRAGMA foreign_keys = false"));
+
+	begin_transaction();
+
+	try
+	{
+		if (fromVersion >= 3)
+		{
+			// Only indexes, tables and triggers were added or changed since version 3
+			create_tables(q);
+			drop_views_and_triggers(q);
+			create_views_and_triggers(q);
+		}
+		else
+		{
+			drop_views_and_triggers(q);
+			// Indexes keep their names when the table is renamed
+			drop_indexes(q);
+
+			exec_query_string(q, "ALTER TABLE tblStats RENAME TO tblStatsOld");
+			exec_query_string(q, "ALTER TABLE tblLessonList RENAME TO tblLessonListOld");
+			exec_query_string(q, "ALTER TABLE tblCourse RENAME TO tblCourseOld");
+			exec_query_string(q, "ALTER TABLE tblLesson RENAME TO tblLessonOld");
+
+			create_tables(q);
+
+			QSqlQuery in(*db);
+			in.setForwardOnly(true);
+
+			// tblLesson
+			exec_query_string(q, "SELECT pkLessonUuid,cLessonTitle,cNewChars,cLessonBuiltin,cText FROM tblLessonOld");
+			in.prepare(QStringLiteral("INSERT INTO tblLesson VALUES (:id, :title, :newChars, :builtin, :text)"));
+			while (q.next())
+			{
+				in.bindValue(":id", encodeUuid(decodeUuid(q.value(0))));
+				in.bindValue(":title", q.value(1));
+				in.bindValue(":newChars", q.value(2));
+				in.bindValue(":builtin", q.value(3));
+				in.bindValue(":text", q.value(4));
+				exec_query(in);
+			}
+
+			// tblCourse
+			exec_query_string(q, "SELECT pkCourseUuid,cCourseTitle,cDescription,cCourseBuiltin FROM tblCourseOld");
+			in.prepare(QStringLiteral("INSERT INTO tblCourse VALUES (:id, :title, :description, :builtin)"));
+			while (q.next())
+			{
+				in.bindValue(":id", encodeUuid(decodeUuid(q.value(0))));
+				in.bindValue(":title", q.value(1));
+				in.bindValue(":description", q.value(2));
+				in.bindValue(":builtin", q.value(3));
+				exec_query(in);
+			}
+
+			// tblLessonList: The IDs and list pointers are taken over as they are (no triggers installed yet)
+			exec_query_string(q, "SELECT pkLessonListId,fkCourseUuid,fkLessonUuid,fkParentId,fkChildId FROM tblLessonListOld");
+			in.prepare(QStringLiteral("INSERT INTO tblLessonList VALUES (:id, :course_id, :lesson_id, :parent_id, :child_id)"));
+			while (q.next())
+			{
+				in.bindValue(":id", q.value(0));
+				in.bindValue(":course_id", encodeUuid(decodeUuid(q.value(1))));
+				in.bindValue(":lesson_id", encodeUuid(decodeUuid(q.value(2))));
+				in.bindValue(":parent_id", q.value(3));
+				in.bindValue(":child_id", q.value(4));
+				exec_query(in);
+			}
+
+			// tblStats
+			exec_query_string(q, "SELECT pkfkLessonListId,pkfkProfileName,pkStartDateTime,cTime,cCharCount,cErrorCount FROM tblStatsOld");
+			in.prepare(QStringLiteral("INSERT INTO tblStats VALUES (:id, :profile, :start, :end, :chars, :errors)"));
+			while (q.next())
+			{
+				in.bindValue(":id", q.value(0));
+				in.bindValue(":profile", q.value(1));
+				in.bindValue(":start", encodeDateTime(decodeDateTime(q.value(2))));
+				in.bindValue(":end", q.value(3));
+				in.bindValue(":chars", q.value(4));
+				in.bindValue(":errors", q.value(5));
+				exec_query(in);
+			}
+
+			exec_query_string(q, "DROP TABLE tblStatsOld");
+			exec_query_string(q, "DROP TABLE tblLessonListOld");
+			exec_query_string(q, "DROP TABLE tblCourseOld");
+			exec_query_string(q, "DROP TABLE tblLessonOld");
+
+			create_views_and_triggers(q);
+		}
+
+		if (fromVersion < 5)
+			exec_query_string(q, QStringLiteral("INSERT OR IGNORE INTO tblLessonGc SELECT pkLessonUuid FROM vDanglingLessons"));
+
+		exec_query_string(q, QString("PRAGMA user_version = %1").arg(VERSION));
+		setMeta(Db::metaSchemaVersionKey, VERSION);
+
+		end_transaction();
+	}
+	catch (...)
+	{
+		qWarning() << "Transaction failed -> Rollback";
+		rollback();
+		exec_query_string(q, QStringLiteral("PRAGMA foreign_keys = true"));
+		throw;
+	}
+
+	exec_query_string(q, QStringLiteral("PRAGMA foreign_keys = true"));
+}
+
+/**
+ * Execute a prepared statement of the DbInterface.
+ * Notifies the query observer and records the statistics if enabled.
+ * @param q A prepared query.
+ */
+void DbV1::exec(QSqlQuery& q)
+{
+	if (!mStatistics)
+	{
+		exec_query(q);
+	}
+	else
+	{
+		QElapsedTimer timer;
+		// Needed to be able to rewind after counting the rows
+		q.setForwardOnly(false);
+		timer.start();
+		exec_query(q);
+		record(q, timer.nsecsElapsed());
+	}
+
+	if (mQueryObserver)
+		mQueryObserver(q);
+}
+
+/**
+ * Execute a statement of the DbInterface.
+ * Notifies the query observer and records the statistics if enabled.
+ * @param q A query.
+ * @param statement The statement.
+ */
+void DbV1::exec(QSqlQuery& q, const QString& statement)
+{
+	if (!mStatistics)
+	{
+		exec_query_string(q, statement);
+	}
+	else
+	{
+		QElapsedTimer timer;
+		q.setForwardOnly(false);
+		timer.start();
+		exec_query_string(q, statement);
+		record(q, timer.nsecsElapsed());
+	}
+
+	if (mQueryObserver)
+		mQueryObserver(q);
+}
+
+/* The caller reads the rows of a select after this returns. To account for the cost of
+ * stepping through the result, all rows are fetched into the cache here and the query is rewound. */
+void DbV1::record(QSqlQuery& q, qint64 execNs)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	int rows = 0;
+	if (q.isSelect())
+	{
+		while (q.next())
+			++rows;
+		q.seek(QSql::BeforeFirstRow);
+	}
+	else
+	{
+		rows = q.numRowsAffected();
+	}
+
+	mStatistics->addStatement(q.lastQuery(), execNs + timer.nsecsElapsed(), rows);
+}
+
 void DbV1::setMeta(const QString& key, const QVariant& value)
 {
 	checkOpen();
@@ -348,7 +688,7 @@ void DbV1::setMeta(const QString& key, const QVariant& value)
 	q.bindValue(":key", key);
 	q.bindValue(":value", value);
 
-	exec_query(q);
+	exec(q);
 }
 
 QVariant DbV1::getMeta(const QString& key)
@@ -361,7 +701,7 @@ QVariant DbV1::getMeta(const QString& key)
 	q.prepare(QStringLiteral("SELECT cValue FROM tblMeta WHERE pkKey = :key"));
 	q.bindValue(":key", key);
 
-	exec_query(q);
+	exec(q);
 
 	if (!q.next())
 	{
@@ -375,6 +715,8 @@ void DbV1::begin_transaction()
 	if (isOpen() && !db->transaction())
 		throw DbException(QStringLiteral("Unable to begin transaction") % (!isOpen() ? ": Database not open" : ""),
 		                  db->lastError());
+	if (mStatistics)
+		mTransactionTimer.start();
 }
 
 void DbV1::end_transaction()
@@ -382,12 +724,22 @@ void DbV1::end_transaction()
 	if (isOpen() && !db->commit())
 		throw DbException(QStringLiteral("Unable to commit transaction") % (!isOpen() ? ": Database not open" : ""),
 		                  db->lastError());
+	if (mStatistics && mTransactionTimer.isValid())
+	{
+		mStatistics->addTransaction(mTransactionTimer.nsecsElapsed(), true);
+		mTransactionTimer.invalidate();
+	}
 }
 
 void DbV1::rollback()
 {
 	if (isOpen())
 		db->rollback();
+	if (mStatistics && mTransactionTimer.isValid())
+	{
+		mStatistics->addTransaction(mTransactionTimer.nsecsElapsed(), false);
+		mTransactionTimer.invalidate();
+	}
 }
 
 /**
@@ -405,7 +757,7 @@ void DbV1::insert(const Profile& profile)
 	q.bindValue(":name", profile.getName());
 	q.bindValue(":skill", profile.getSkillLevel());
 
-	exec_query(q);
+	exec(q);
 }
 
 /**
@@ -420,15 +772,15 @@ void DbV1::insert(const Stats& stats)
 	q.setForwardOnly(true);
 
 	q.prepare(QStringLiteral("INSERT INTO tblStats VALUES ((SELECT pkLessonListId FROM tblLessonList WHERE fkCourseUuid = :course AND fkLessonUuid = :lesson), :profile, :start, :end, :chars, :errors)"));
-	q.bindValue(":course", stats.getCourseId());
-	q.bindValue(":lesson", stats.getLessonId());
+	q.bindValue(":course", encodeUuid(stats.getCourseId()));
+	q.bindValue(":lesson", encodeUuid(stats.getLessonId()));
 	q.bindValue(":profile", stats.getProfileName());
-	q.bindValue(":start", stats.getStart());
+	q.bindValue(":start", encodeDateTime(stats.getStart()));
 	q.bindValue(":end", stats.getTime());
 	q.bindValue(":chars", stats.getCharCount());
 	q.bindValue(":errors", stats.getErrorCount());
 
-	exec_query(q);
+	exec(q);
 }
 
 /**
@@ -443,12 +795,12 @@ void DbV1::insert(const Course& course)
 	q.setForwardOnly(true);
 
 	q.prepare(QStringLiteral("INSERT INTO tblCourse VALUES (:id, :title, :description, :builtin)"));
-	q.bindValue(":id", course.getId());
+	q.bindValue(":id", encodeUuid(course.getId()));
 	q.bindValue(":title", course.getTitle());
 	q.bindValue(":description", course.getDescription());
 	q.bindValue(":builtin", course.isBuiltin());
 
-	exec_query(q);
+	exec(q);
 }
 
 /**
@@ -463,13 +815,13 @@ void DbV1::insert(const Lesson& lesson)
 	q.setForwardOnly(true);
 
 	q.prepare(QStringLiteral("INSERT INTO tblLesson VALUES (:id, :title, :newChars, :builtin, :text)"));
-	q.bindValue(":id", lesson.getId());
+	q.bindValue(":id", encodeUuid(lesson.getId()));
 	q.bindValue(":title", lesson.getTitle());
 	q.bindValue(":newChars", lesson.getNewChars());
 	q.bindValue(":builtin", lesson.isBuiltin());
 	q.bindValue(":text", lesson.getText());
 
-	exec_query(q);
+	exec(q);
 }
 
 int DbV1::insert(const QUuid& courseId, const QUuid& lessonId, int parentId)
@@ -482,19 +834,19 @@ int DbV1::insert(const QUuid& courseId, const QUuid& lessonId, int parentId)
 	if (!parentId)
 	{
 		q.prepare(QStringLiteral("INSERT INTO tblLessonList(fkCourseUuid,fkLessonUuid) VALUES (:course_id, :lesson_id)"));
-		q.bindValue(":course_id", courseId);
-		q.bindValue(":lesson_id", lessonId);
+		q.bindValue(":course_id", encodeUuid(courseId));
+		q.bindValue(":lesson_id", encodeUuid(lessonId));
 	}
 	else
 	{
 		q.prepare(
 		    QStringLiteral("INSERT INTO tblLessonList(fkCourseUuid,fkLessonUuid,fkParentId) VALUES (:course_id, :lesson_id, :parent_id)"));
-		q.bindValue(":course_id", courseId);
-		q.bindValue(":lesson_id", lessonId);
+		q.bindValue(":course_id", encodeUuid(courseId));
+		q.bindValue(":lesson_id", encodeUuid(lessonId));
 		q.bindValue(":parent_id", parentId);
 	}
 
-	exec_query(q);
+	exec(q);
 
 	return q.lastInsertId().toInt();
 }
@@ -511,7 +863,7 @@ void DbV1::update(const Profile& profile)
 	q.bindValue(":profile", profile.getName());
 	q.bindValue(":skill", profile.getSkillLevel());
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::update(const Stats& /*stats*/)
@@ -534,9 +886,9 @@ void DbV1::update(const Course& course)
 	q.bindValue(":title", course.getTitle());
 	q.bindValue(":description", course.getDescription());
 	q.bindValue(":builtin", course.isBuiltin());
-	q.bindValue(":id", course.getId());
+	q.bindValue(":id", encodeUuid(course.getId()));
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::update(const Lesson& lesson)
@@ -552,9 +904,9 @@ void DbV1::update(const Lesson& lesson)
 	q.bindValue(":newChars", lesson.getNewChars());
 	q.bindValue(":builtin", lesson.isBuiltin());
 	q.bindValue(":text", lesson.getText());
-	q.bindValue(":id", lesson.getId());
+	q.bindValue(":id", encodeUuid(lesson.getId()));
 
-	exec_query(q);
+	exec(q);
 }
 
 /**
@@ -569,7 +921,7 @@ QSqlQuery DbV1::selectProfiles()
 	QSqlQuery q(*db);
 	q.setForwardOnly(true);
 
-	exec_query_string(q, QStringLiteral("SELECT pkProfileName,cSkillLevel FROM tblProfile"));
+	exec(q, QStringLiteral("SELECT pkProfileName,cSkillLevel FROM tblProfile"));
 
 	return q;
 }
@@ -587,11 +939,40 @@ QSqlQuery DbV1::selectStats(const QString& profileName)
 	QSqlQuery q(*db);
 	q.setForwardOnly(true);
 
+	/* Note: Joining tblLessonList directly instead of vLessons avoids the recursive
+	 * expansion of all LessonLists. */
+	q.prepare(
+	    QStringLiteral("SELECT fkCourseUuid AS pkCourseUuid,fkLessonUuid AS pkLessonUuid,pkStartDateTime,cTime,cCharCount,cErrorCount FROM tblStats JOIN tblLessonList ON pkLessonListId = pkfkLessonListId WHERE pkfkProfileName = :profileName ORDER BY pkStartDateTime"));
+	q.bindValue(":profileName", profileName);
+
+	exec(q);
+
+	return q;
+}
+
+/**
+ * Select the Stats of a given ProfileName that were started in a given time range.
+ * The range scan is backed by idxStatsProfileStart.
+ * Valid columns: pkCourseUuid, pkLessonUuid, pkStartDateTime, cTime, cCharCount, cErrorCount
+ * @param profileName A ProfileName
+ * @param from Start of the range (inclusive).
+ * @param to End of the range (exclusive).
+ * @return The query.
+ */
+QSqlQuery DbV1::selectStats(const QString& profileName, const QDateTime& from, const QDateTime& to)
+{
+	checkOpen();
+
+	QSqlQuery q(*db);
+	q.setForwardOnly(true);
+
 	q.prepare(
-	    QStringLiteral("SELECT pkCourseUuid,pkLessonUuid,pkStartDateTime,cTime,cCharCount,cErrorCount FROM tblStats JOIN vLessons ON pkLessonListId = pkfkLessonListId WHERE pkfkProfileName = :profileName ORDER BY pkStartDateTime"));
+	    QStringLiteral("SELECT fkCourseUuid AS pkCourseUuid,fkLessonUuid AS pkLessonUuid,pkStartDateTime,cTime,cCharCount,cErrorCount FROM tblStats JOIN tblLessonList ON pkLessonListId = pkfkLessonListId WHERE pkfkProfileName = :profileName AND pkStartDateTime >= :from AND pkStartDateTime < :to ORDER BY pkStartDateTime"));
 	q.bindValue(":profileName", profileName);
+	q.bindValue(":from", encodeDateTime(from));
+	q.bindValue(":to", encodeDateTime(to));
 
-	exec_query(q);
+	exec(q);
 
 	return q;
 }
@@ -619,7 +1000,7 @@ QSqlQuery DbV1::selectCourses(Db::CourseType type)
 	if (Db::All != type)
 		q.bindValue(":builtin", (Db::BuiltIn == type ? "1" : "0"));
 
-	exec_query(q);
+	exec(q);
 
 	return q;
 }
@@ -639,9 +1020,9 @@ QSqlQuery DbV1::selectCourse(const QUuid& courseId)
 
 	q.prepare(
 	    QStringLiteral("SELECT pkCourseUuid,cCourseTitle,cDescription,cCourseBuiltin FROM tblCourse WHERE pkCourseUuid = :course_id"));
-	q.bindValue(":course_id", courseId);
+	q.bindValue(":course_id", encodeUuid(courseId));
 
-	exec_query(q);
+	exec(q);
 
 	return q;
 }
@@ -661,9 +1042,9 @@ QSqlQuery DbV1::selectLesson(const QUuid& lessonId)
 
 	q.prepare(
 	    QStringLiteral("SELECT pkLessonUuid,cLessonTitle,cNewChars,cLessonBuiltin,cText FROM tblLesson WHERE pkLessonUuid = :lesson_id"));
-	q.bindValue(":lesson_id", lessonId);
+	q.bindValue(":lesson_id", encodeUuid(lessonId));
 
-	exec_query(q);
+	exec(q);
 
 	return q;
 }
@@ -681,11 +1062,19 @@ QSqlQuery DbV1::selectLessonList(const QUuid& courseId)
 	QSqlQuery q(*db);
 	q.setForwardOnly(true);
 
+	/* Note: vLessons expands the LessonLists of all courses before filtering.
+	 * Walk the list of the requested course only, starting at its head. */
 	q.prepare(
-	    QStringLiteral("SELECT pkLessonUuid,cLessonTitle,cNewChars,cLessonBuiltin,cText FROM vLessons WHERE pkCourseUuid = :course_id"));
-	q.bindValue(":course_id", courseId);
+	    QStringLiteral("WITH RECURSIVE LessonList(pkLessonListId, fkLessonUuid, fkChildId, cPosition) AS (\n"
+	                   "	SELECT pkLessonListId, fkLessonUuid, fkChildId, 0 FROM tblLessonList WHERE fkCourseUuid = :course_id AND fkParentId IS NULL\n"
+	                   "	UNION ALL\n"
+	                   "	SELECT tblLessonList.pkLessonListId, tblLessonList.fkLessonUuid, tblLessonList.fkChildId, LessonList.cPosition + 1\n"
+	                   "		FROM tblLessonList JOIN LessonList ON tblLessonList.pkLessonListId = LessonList.fkChildId\n"
+	                   ")\n"
+	                   "SELECT pkLessonUuid,cLessonTitle,cNewChars,cLessonBuiltin,cText FROM LessonList JOIN tblLesson ON pkLessonUuid = fkLessonUuid ORDER BY cPosition"));
+	q.bindValue(":course_id", encodeUuid(courseId));
 
-	exec_query(q);
+	exec(q);
 
 	return q;
 }
@@ -702,7 +1091,7 @@ QSqlQuery DbV1::selectDanglingLesson()
 	QSqlQuery q(*db);
 	q.setForwardOnly(true);
 
-	exec_query_string(q, QStringLiteral("SELECT pkLessonUuid FROM vDanglingLessons"));
+	exec(q, QStringLiteral("SELECT pkLessonUuid FROM vDanglingLessons"));
 
 	return q;
 }
@@ -718,7 +1107,7 @@ void DbV1::deleteProfile(const QString& profileName)
 	    QStringLiteral("DELETE FROM tblProfile WHERE pkProfileName = :profile"));
 	q.bindValue(":profile", profileName);
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::deleteStats(const QString& profileName)
@@ -732,7 +1121,7 @@ void DbV1::deleteStats(const QString& profileName)
 	    QStringLiteral("DELETE FROM tblStats WHERE pkfkProfileName = :profile"));
 	q.bindValue(":profile", profileName);
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::deleteCourse(const QUuid& courseId)
@@ -744,9 +1133,9 @@ void DbV1::deleteCourse(const QUuid& courseId)
 
 	q.prepare(
 	    QStringLiteral("DELETE FROM tblCourse WHERE pkCourseUuid = :course"));
-	q.bindValue(":course", courseId);
+	q.bindValue(":course", encodeUuid(courseId));
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::deleteLesson(const QUuid& lessonId)
@@ -758,9 +1147,9 @@ void DbV1::deleteLesson(const QUuid& lessonId)
 
 	q.prepare(
 	    QStringLiteral("DELETE FROM tblLesson WHERE pkLessonUuid = :lesson"));
-	q.bindValue(":lesson", lessonId);
+	q.bindValue(":lesson", encodeUuid(lessonId));
 
-	exec_query(q);
+	exec(q);
 }
 
 void DbV1::deleteLessonList(const QUuid& courseId)
@@ -771,10 +1160,56 @@ void DbV1::deleteLessonList(const QUuid& courseId)
 	q.setForwardOnly(true);
 
 	q.prepare(
-	    QStringLiteral("DELETE FROM tblLessonList WHERE fkCourseUuid IN (SELECT pkCourseUuid FROM vLessons WHERE pkCourseUuid = :course)"));
-	q.bindValue(":course", courseId);
+	    QStringLiteral("DELETE FROM tblLessonList WHERE fkCourseUuid = :course"));
+	q.bindValue(":course", encodeUuid(courseId));
+
+	exec(q);
+}
+
+/**
+ * Delete the Lessons among the next garbage collection candidates that are not used by any Course.
+ * Only built-in Lessons are deleted. The processed candidates are removed.
+ * @param limit The maximum number of candidates to process.
+ * @return The number of deleted Lessons.
+ */
+int DbV1::deleteDanglingLessons(int limit)
+{
+	checkOpen();
+
+	QSqlQuery q(*db);
+	q.setForwardOnly(true);
+
+	q.prepare(
+	    QStringLiteral("DELETE FROM tblLesson WHERE pkLessonUuid IN (SELECT pkLessonUuid FROM tblLessonGc ORDER BY pkLessonUuid LIMIT :limit) AND cLessonBuiltin AND NOT EXISTS (SELECT 1 FROM tblLessonList WHERE fkLessonUuid = tblLesson.pkLessonUuid)"));
+	q.bindValue(":limit", limit);
+
+	exec(q);
+	int deleted = q.numRowsAffected();
+
+	q.prepare(
+	    QStringLiteral("DELETE FROM tblLessonGc WHERE pkLessonUuid IN (SELECT pkLessonUuid FROM tblLessonGc ORDER BY pkLessonUuid LIMIT :limit)"));
+	q.bindValue(":limit", limit);
+
+	exec(q);
+
+	return deleted;
+}
+
+/**
+ * Check for remaining garbage collection candidates.
+ * Stops at the first row instead of counting the whole table.
+ * @return true if there are candidates left.
+ */
+bool DbV1::hasLessonGcCandidates()
+{
+	checkOpen();
+
+	QSqlQuery q(*db);
+	q.setForwardOnly(true);
+
+	exec(q, QStringLiteral("SELECT EXISTS(SELECT 1 FROM tblLessonGc)"));
 
-	exec_query(q);
+	return q.next() && q.value(0).toBool();
 }
 
 } /* namespace qtouch */
@@ -28,7 +28,10 @@
 #define DBV1_HPP_
 
 #include <memory>
+#include <functional>
+#include <QElapsedTimer>
 #include "dbinterface.hpp"
+#include "dbstatistics.hpp"
 
 class QSqlDatabase;
 
@@ -38,9 +41,28 @@ namespace qtouch
 class DbV1: public DbInterface
 {
 public:
-	const int VERSION = 1;
+	const int VERSION = 6;
 
 	static std::unique_ptr<DbV1> create();
+
+	/* UUID encoding */
+	static QByteArray encodeUuid(const QUuid& uuid);
+	static QUuid decodeUuid(const QVariant& column);
+	inline QUuid toUuid(const QVariant& column) const Q_DECL_OVERRIDE { return decodeUuid(column); }
+
+	/* DateTime encoding */
+	static qint64 encodeDateTime(const QDateTime& dateTime);
+	static QDateTime decodeDateTime(const QVariant& column);
+	inline QDateTime toDateTime(const QVariant& column) const Q_DECL_OVERRIDE { return decodeDateTime(column); }
+
+	/* Observation of executed statements (schema handling excluded) */
+	typedef std::function<void(const QSqlQuery&)> QueryObserver;
+	inline void setQueryObserver(const QueryObserver& observer) { mQueryObserver = observer; }
+
+	/* Statement statistics (disabled by default, see DbStatistics::ENV_VAR) */
+	void setStatisticsEnabled(bool enabled);
+	inline DbStatistics* getStatistics() const { return mStatistics.get(); }
+
 	virtual ~DbV1();
 
 	/* Connection handling */
@@ -51,6 +73,7 @@ public:
 	/* Schema */
 	void createSchema() Q_DECL_OVERRIDE;
 	void dropSchema() Q_DECL_OVERRIDE;
+	void migrateSchema(int fromVersion) Q_DECL_OVERRIDE;
 
 	/* MetaTable */
 	void setMeta(const QString& key, const QVariant& value) Q_DECL_OVERRIDE;
@@ -77,6 +100,7 @@ public:
 	/* SELECT */
 	QSqlQuery selectProfiles() Q_DECL_OVERRIDE;
 	QSqlQuery selectStats(const QString& profileName) Q_DECL_OVERRIDE;
+	QSqlQuery selectStats(const QString& profileName, const QDateTime& from, const QDateTime& to) Q_DECL_OVERRIDE;
 	QSqlQuery selectCourses(Db::CourseType type) Q_DECL_OVERRIDE;
 	QSqlQuery selectCourse(const QUuid& courseId) Q_DECL_OVERRIDE;
 	QSqlQuery selectLesson(const QUuid& lessonId) Q_DECL_OVERRIDE;
@@ -90,13 +114,23 @@ public:
 	void deleteLesson(const QUuid& lessonId) Q_DECL_OVERRIDE;
 	void deleteLessonList(const QUuid& courseId) Q_DECL_OVERRIDE;
 
+	int deleteDanglingLessons(int limit) Q_DECL_OVERRIDE;
+	bool hasLessonGcCandidates() Q_DECL_OVERRIDE;
+
 private:
 	DbV1() {}
 	Q_DISABLE_COPY(DbV1)
 
 	inline void checkOpen() { if (!isOpen()) throw DbException("Database not open"); }
 
+	void exec(QSqlQuery& q);
+	void exec(QSqlQuery& q, const QString& statement);
+	void record(QSqlQuery& q, qint64 execNs);
+
 	std::unique_ptr<QSqlDatabase> db;
+	QueryObserver mQueryObserver;
+	std::unique_ptr<DbStatistics> mStatistics;
+	QElapsedTimer mTransactionTimer;
 };
 
 } /* namespace qtouch */
@@ -25,6 +25,7 @@
  */
 
 #include <QtTest/QtTest>
+#include <QSqlDatabase>
 #include <sqlite3.h>
 
 #include "dbv1.hpp"
@@ -50,12 +51,17 @@ private slots:
 	void noPathTest();
 	void invalidPathTest();
 
+	void uuidCodingTest();
+	void migrateSchemaTest();
+
 	void insertCourseTest();
 	void insertCoursesTest();
 	void insertCustomCourseTest();
 
 	void insertProfileTest();
 	void insertStatsTest();
+	void selectStatsRangeTest();
+	void statisticsTest();
 
 	void updateCourseTest();
 
@@ -151,7 +157,7 @@ void DbV1Test::getCoursesAndLessons(Db::CourseType type,
 	{
 		auto target = Course::create();
 		// pkCourseUuid, cCourseTitle, cDescription, cCourseBuiltin
-		target->setId(QUuid(qC.value("pkCourseUuid").toString()));
+		target->setId(DbV1::decodeUuid(qC.value("pkCourseUuid")));
 		target->setTitle(qC.value("cCourseTitle").toString());
 		target->setDescription(qC.value("cDescription").toString());
 		target->setBuiltin(qC.value("cCourseBuiltin").toBool());
@@ -165,7 +171,7 @@ void DbV1Test::getCoursesAndLessons(Db::CourseType type,
 		{
 			Lesson lesson;
 			// pkLessonUuid, cLessonTitle, cNewChars, cLessonBuiltin, cText
-			lesson.setId(QUuid(qL.value("pkLessonUuid").toString()));
+			lesson.setId(DbV1::decodeUuid(qL.value("pkLessonUuid")));
 			lesson.setTitle(qL.value("cLessonTitle").toString());
 			lesson.setNewChars(qL.value("cNewChars").toString());
 			lesson.setBuiltin(qL.value("cLessonBuiltin").toBool());
@@ -193,6 +199,76 @@ void DbV1Test::invalidPathTest()
 	reset();
 }
 
+void DbV1Test::uuidCodingTest()
+{
+	QUuid id = QUuid::createUuid();
+
+	QByteArray blob = DbV1::encodeUuid(id);
+	QCOMPARE(blob.size(), 16);
+	QCOMPARE(DbV1::decodeUuid(blob), id);
+
+	// Textual UUIDs of not yet migrated databases
+	QCOMPARE(DbV1::decodeUuid(id.toString()), id);
+
+	QVERIFY(DbV1::decodeUuid(QVariant()).isNull());
+
+	// DateTimes are stored as UTC based milliseconds and read back as local time
+	QDateTime now = QDateTime::currentDateTime();
+	QCOMPARE(DbV1::decodeDateTime(DbV1::encodeDateTime(now)), now);
+	QCOMPARE(DbV1::decodeDateTime(DbV1::encodeDateTime(now.toUTC())), now);
+
+	// ISO strings of not yet migrated databases
+	QCOMPARE(DbV1::decodeDateTime(now.toString(Qt::ISODate)), now.addMSecs(-now.time().msec()));
+}
+
+void DbV1Test::migrateSchemaTest()
+{
+	QUuid courseId = QUuid::createUuid();
+	QUuid lessonId = QUuid::createUuid();
+
+	reset();
+
+	try
+	{
+		// Fake a version 1 database by storing the UUIDs in their textual form
+		QSqlQuery q(QSqlDatabase::database());
+		QVERIFY(q.exec(QString("INSERT INTO tblCourse VALUES ('%1', 'Course', 'Description', 0)").arg(courseId.toString())));
+		QVERIFY(q.exec(QString("INSERT INTO tblLesson VALUES ('%1', 'Lesson', 'f', 0, 'fff')").arg(lessonId.toString())));
+		QVERIFY(q.exec(QString("INSERT INTO tblLessonList(fkCourseUuid,fkLessonUuid) VALUES ('%1', '%2')")
+		               .arg(courseId.toString()).arg(lessonId.toString())));
+		QVERIFY(q.exec(QStringLiteral("INSERT INTO tblProfile VALUES ('MigrationUser', 0)")));
+		QVERIFY(q.exec(QStringLiteral("INSERT INTO tblStats VALUES ((SELECT pkLessonListId FROM tblLessonList), 'MigrationUser', '2015-07-01T14:44:52', 60000, 100, 5)")));
+		QVERIFY(q.exec(QStringLiteral("PRAGMA user_version = 1")));
+
+		db->migrateSchema(1);
+
+		QCOMPARE(db->getMeta(Db::metaSchemaVersionKey).toInt(), db->VERSION);
+
+		// The migrated rows must be found by their binary UUIDs
+		auto cC = db->selectCourse(courseId);
+		QVERIFY(cC.next());
+		QCOMPARE(DbV1::decodeUuid(cC.value("pkCourseUuid")), courseId);
+		QCOMPARE(cC.value("pkCourseUuid").toByteArray(), DbV1::encodeUuid(courseId));
+
+		auto cL = db->selectLessonList(courseId);
+		QVERIFY(cL.next());
+		QCOMPARE(DbV1::decodeUuid(cL.value("pkLessonUuid")), lessonId);
+		QCOMPARE(cL.value("cText").toString(), QStringLiteral("fff"));
+
+		auto cS = db->selectStats(QStringLiteral("MigrationUser"));
+		QVERIFY(cS.next());
+		QCOMPARE(cS.value("pkStartDateTime").type(), QVariant::LongLong);
+		QCOMPARE(DbV1::decodeDateTime(cS.value("pkStartDateTime")), QDateTime(QDate(2015, 7, 1), QTime(14, 44, 52)));
+	}
+	catch (DbException& e)
+	{
+		QFAIL(qUtf8Printable(e.message()));
+	}
+
+	// Force recreation
+	reset();
+}
+
 void DbV1Test::insertCourseTest()
 {
 	std::shared_ptr<const Course> source;
@@ -418,12 +494,12 @@ void DbV1Test::insertStatsTest()
 
 		// Read the LessonList of the first Course
 		// pkLessonUuid, cLessonTitle, cNewChars, cLessonBuiltin, cText
-		auto cL = db->selectLessonList(QUuid(cC.value("pkCourseUuid").toString()));
+		auto cL = db->selectLessonList(DbV1::decodeUuid(cC.value("pkCourseUuid")));
 		QVERIFY(cL.next() != false);
 
 		/* Take the first lesson and create a stats object
 		with the lessonId from the Db */
-		Stats stats(QUuid(cC.value("pkCourseUuid").toString()), QUuid(cL.value("pkLessonUuid").toString()), cP.value("pkProfileName").toString(), start);
+		Stats stats(DbV1::decodeUuid(cC.value("pkCourseUuid")), DbV1::decodeUuid(cL.value("pkLessonUuid")), cP.value("pkProfileName").toString(), start);
 		stats.setTime(time);
 		stats.setCharCount(chars);
 		stats.setErrorCount(errors);
@@ -436,9 +512,9 @@ void DbV1Test::insertStatsTest()
 		auto cS = db->selectStats(cP.value("pkProfileName").toString());
 		QVERIFY(cS.next() != false);
 
-		QCOMPARE(QUuid(cS.value("pkCourseUuid").toString()), QUuid(cC.value("pkCourseUuid").toString()));
-		QCOMPARE(QUuid(cS.value("pkLessonUuid").toString()), QUuid(cL.value("pkLessonUuid").toString()));
-		QCOMPARE(cS.value("pkStartDateTime").toDateTime(), start);
+		QCOMPARE(DbV1::decodeUuid(cS.value("pkCourseUuid")), DbV1::decodeUuid(cC.value("pkCourseUuid")));
+		QCOMPARE(DbV1::decodeUuid(cS.value("pkLessonUuid")), DbV1::decodeUuid(cL.value("pkLessonUuid")));
+		QCOMPARE(DbV1::decodeDateTime(cS.value("pkStartDateTime")), start);
 		QCOMPARE(cS.value("cTime").toUInt(), time);
 		QCOMPARE(cS.value("cCharCount").toUInt(), chars);
 		QCOMPARE(cS.value("cErrorCount").toUInt(), errors);
@@ -449,6 +525,107 @@ void DbV1Test::insertStatsTest()
 	}
 }
 
+/* NOTE: This test depends on the Profile and Stats added by the insert tests! */
+void DbV1Test::selectStatsRangeTest()
+{
+	QDateTime now = QDateTime::currentDateTime();
+
+	open();
+
+	try
+	{
+		auto cP = db->selectProfiles();
+		QVERIFY(cP.next() != false);
+		QString profileName = cP.value("pkProfileName").toString();
+
+		auto cC = db->selectCourses(Db::All);
+		QVERIFY(cC.next() != false);
+		QUuid courseId = DbV1::decodeUuid(cC.value("pkCourseUuid"));
+
+		auto cL = db->selectLessonList(courseId);
+		QVERIFY(cL.next() != false);
+		QUuid lessonId = DbV1::decodeUuid(cL.value("pkLessonUuid"));
+
+		// One session 10 days and one 3 days ago
+		db->insert(Stats(courseId, lessonId, profileName, now.addDays(-10)));
+		db->insert(Stats(courseId, lessonId, profileName, now.addDays(-3)));
+
+		// Last 7 days up to yesterday (excludes the session inserted by insertStatsTest)
+		auto cS = db->selectStats(profileName, now.addDays(-7), now.addDays(-1));
+		QVERIFY(cS.next() != false);
+		QCOMPARE(DbV1::decodeDateTime(cS.value("pkStartDateTime")), now.addDays(-3));
+		QCOMPARE(DbV1::decodeUuid(cS.value("pkCourseUuid")), courseId);
+		QCOMPARE(DbV1::decodeUuid(cS.value("pkLessonUuid")), lessonId);
+		QVERIFY(cS.next() == false);
+
+		// Both are in the last 30 days and sorted ascending
+		cS = db->selectStats(profileName, now.addDays(-30), now.addDays(-1));
+		QVERIFY(cS.next() != false);
+		QCOMPARE(DbV1::decodeDateTime(cS.value("pkStartDateTime")), now.addDays(-10));
+		QVERIFY(cS.next() != false);
+		QCOMPARE(DbV1::decodeDateTime(cS.value("pkStartDateTime")), now.addDays(-3));
+		QVERIFY(cS.next() == false);
+	}
+	catch (DbException& e)
+	{
+		QFAIL(qUtf8Printable(e.message()));
+	}
+}
+
+/* NOTE: This test depends on the Profile added by insertProfileTest! */
+void DbV1Test::statisticsTest()
+{
+	db->setStatisticsEnabled(true);
+	QVERIFY(db->getStatistics() != nullptr);
+
+	open();
+
+	try
+	{
+		// Selects are counted without consuming the result
+		auto cP = db->selectProfiles();
+		int profiles = 0;
+		while (cP.next())
+			++profiles;
+		QVERIFY(profiles > 0);
+
+		db->selectProfiles();
+
+		db->begin_transaction();
+		db->deleteProfile(QStringLiteral("NoSuchProfile"));
+		db->rollback();
+
+		const DbStatistics* stats = db->getStatistics();
+		auto it = stats->getStatements().find(cP.lastQuery());
+		QVERIFY(it != stats->getStatements().end());
+		QCOMPARE(it->second.count, quint64(2));
+		QCOMPARE(it->second.rows, quint64(2 * profiles));
+		QVERIFY(it->second.totalNs > 0);
+		QVERIFY(it->second.maxNs <= it->second.totalNs);
+		QVERIFY(it->second.percentile(0.5) <= it->second.maxNs);
+
+		QCOMPARE(stats->getRollbacks().count, quint64(1));
+		QCOMPARE(stats->getCommits().count, quint64(0));
+
+		QVERIFY(stats->dump().contains(QStringLiteral("FROM tblProfile")));
+	}
+	catch (DbException& e)
+	{
+		db->setStatisticsEnabled(false);
+		QFAIL(qUtf8Printable(e.message()));
+	}
+
+	db->setStatisticsEnabled(false);
+	QVERIFY(db->getStatistics() == nullptr);
+
+	QCOMPARE(DbStatistics::bucket(0), 0);
+	QCOMPARE(DbStatistics::bucket(999), 0);
+	QCOMPARE(DbStatistics::bucket(1000), 1);
+	QCOMPARE(DbStatistics::bucket(1999), 1);
+	QCOMPARE(DbStatistics::bucket(2000), 2);
+	QCOMPARE(DbStatistics::bucket(Q_INT64_C(1) << 60), DbStatistics::BUCKETS - 1);
+}
+
 /* NOTE: This test currently depends on the Course added by insertCustomCourse!
  * So don't reset the Db in any test before! */
 void DbV1Test::updateCourseTest()
@@ -0,0 +1,425 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file queryplan_test.cpp
+ *
+ * Executes every statement of DbV1 against a seeded database and checks
+ * its query plan for full scans of the large tables. The statements run by the
+ * triggers and the foreign key actions are not reported by the driver and are
+ * checked separately.
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <QtTest/QtTest>
+#include <QSqlDatabase>
+
+#include <functional>
+#include <map>
+
+#include "dbv1.hpp"
+
+namespace qtouch
+{
+
+class QueryPlanTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	// will be called before the first test function is executed
+	void initTestCase();
+	//  will be called after the last test function was executed.
+	void cleanupTestCase();
+
+	void queryPlanTest_data();
+	void queryPlanTest();
+
+	void triggerPlanTest_data();
+	void triggerPlanTest();
+
+private:
+	void seed();
+	std::shared_ptr<Course> createCourse(const QUuid& id) const;
+	Lesson createLesson(const QUuid& id) const;
+	QStringList explain(const QString& statement, const QMap<QString, QVariant>& bindings);
+	QString findScan(const QStringList& plan, const QStringList& allowedScans) const;
+
+	std::unique_ptr<DbV1> db;
+
+	/* Statement name -> Call of the statement through the DbInterface */
+	std::map<QString, std::function<void()>> mStatements;
+
+	/* Statements and bindings executed by the current test row */
+	std::vector<std::pair<QString, QMap<QString, QVariant>>> mObserved;
+
+	QString mProfileName;
+	QUuid mCourseId;
+	QUuid mLessonId;
+	QUuid mHeadLessonId;
+	int mLessonListId = 0;
+};
+
+/* Size of the seeded database */
+const int COURSES = 50;
+const int LESSONS_PER_COURSE = 40;
+const int PROFILES = 5;
+const int STATS_PER_PROFILE = 2000;
+
+/* The tables that grow with usage. A SCAN of them is a regression. */
+const QRegularExpression fullScan(QStringLiteral("\\bSCAN (TABLE )?(tblLesson|tblLessonList|tblStats)\\b"));
+
+void QueryPlanTest::initTestCase()
+{
+	db = DbV1::create();
+
+	try
+	{
+		db->open(QStringLiteral("QueryPlanDb.sqlite"));
+		db->dropSchema();
+		db->createSchema();
+		seed();
+	}
+	catch (DbException& e)
+	{
+		QFAIL(qUtf8Printable(e.message()));
+	}
+
+	db->setQueryObserver([this](const QSqlQuery& q)
+	{
+		mObserved.push_back(std::make_pair(q.lastQuery(), q.boundValues()));
+	});
+
+	/* Every statement of the DbInterface that hits the database.
+	 * The data is not changed since every statement is rolled back. */
+	mStatements = {
+		{ "selectProfiles", [this] { db->selectProfiles(); } },
+		{ "selectStats", [this] { db->selectStats(mProfileName); } },
+		{ "selectStatsRange", [this] {
+				QDateTime now = QDateTime::currentDateTime();
+				db->selectStats(mProfileName, now.addDays(-7), now);
+			}
+		},
+		{ "selectCourse", [this] { db->selectCourse(mCourseId); } },
+		{ "selectLesson", [this] { db->selectLesson(mLessonId); } },
+		{ "selectLessonList", [this] { db->selectLessonList(mCourseId); } },
+		{ "selectDanglingLesson", [this] { db->selectDanglingLesson(); } },
+		{ "insertProfile", [this] { db->insert(Profile("QueryPlanUser")); } },
+		{ "insertStats", [this] { db->insert(Stats(mCourseId, mLessonId, mProfileName)); } },
+		{ "insertCourse", [this] { db->insert(*createCourse(QUuid())); } },
+		{ "insertLesson", [this] { db->insert(createLesson(QUuid())); } },
+		{ "insertLessonList", [this] {
+				// Append a lesson to the list of a new course
+				auto course = createCourse(QUuid());
+				db->insert(*course);
+				int parentId = db->insert(course->getId(), mLessonId, 0);
+				db->insert(course->getId(), mHeadLessonId, parentId);
+			}
+		},
+		{ "updateProfile", [this] { db->update(Profile(mProfileName, Profile::Advanced)); } },
+		{ "updateCourse", [this] { db->update(*createCourse(mCourseId)); } },
+		{ "updateLesson", [this] { db->update(createLesson(mLessonId)); } },
+		{ "deleteProfile", [this] { db->deleteProfile(mProfileName); } },
+		{ "deleteStats", [this] { db->deleteStats(mProfileName); } },
+		{ "deleteCourse", [this] { db->deleteCourse(mCourseId); } },
+		{ "deleteLesson", [this] { db->deleteLesson(mLessonId); } },
+		{ "deleteLessonList", [this] { db->deleteLessonList(mCourseId); } },
+		{ "deleteDanglingLessons", [this] {
+				// Create candidates
+				db->deleteLessonList(mCourseId);
+				mObserved.clear();
+				db->deleteDanglingLessons(10);
+			}
+		},
+		{ "hasLessonGcCandidates", [this] { db->hasLessonGcCandidates(); } },
+		{ "setMeta", [this] { db->setMeta(QStringLiteral("QueryPlanKey"), 1); } },
+		{ "getMeta", [this] { db->getMeta(Db::metaSchemaVersionKey); } }
+	};
+}
+
+void QueryPlanTest::cleanupTestCase()
+{
+	db->setQueryObserver(DbV1::QueryObserver());
+	db->close();
+}
+
+/* Fill the Db with enough data to make the planner distinguish between scans and searches */
+void QueryPlanTest::seed()
+{
+	db->begin_transaction();
+
+	for (int p = 0; p < PROFILES; ++p)
+		db->insert(Profile(QStringLiteral("Profile %1").arg(p)));
+
+	std::vector<std::pair<QUuid, QUuid>> lessonLists;
+
+	for (int c = 0; c < COURSES; ++c)
+	{
+		auto course = createCourse(QUuid());
+		course->setBuiltin(c % 2);
+		db->insert(*course);
+
+		int parentId = 0;
+		for (int l = 0; l < LESSONS_PER_COURSE; ++l)
+		{
+			Lesson lesson = createLesson(QUuid());
+			db->insert(lesson);
+
+			parentId = db->insert(course->getId(), lesson.getId(), parentId);
+			lessonLists.push_back(std::make_pair(course->getId(), lesson.getId()));
+
+			if (c == COURSES / 2 && l == LESSONS_PER_COURSE / 2)
+				mLessonListId = parentId;
+		}
+	}
+
+	QDateTime start = QDateTime::currentDateTime().addYears(-1);
+	for (int p = 0; p < PROFILES; ++p)
+	{
+		for (int s = 0; s < STATS_PER_PROFILE; ++s)
+		{
+			const auto& ll = lessonLists.at((p * STATS_PER_PROFILE + s) % lessonLists.size());
+			db->insert(Stats(ll.first, ll.second, QStringLiteral("Profile %1").arg(p), start.addSecs(s * 600)));
+		}
+	}
+
+	// Dangling lessons
+	for (int l = 0; l < LESSONS_PER_COURSE; ++l)
+		db->insert(createLesson(QUuid()));
+
+	db->end_transaction();
+
+	// Pick something in the middle
+	mProfileName = QStringLiteral("Profile %1").arg(PROFILES / 2);
+	mCourseId = lessonLists.at(lessonLists.size() / 2).first;
+	mLessonId = lessonLists.at(lessonLists.size() / 2).second;
+	mHeadLessonId = lessonLists.front().second;
+}
+
+/* A null id creates a new one */
+std::shared_ptr<Course> QueryPlanTest::createCourse(const QUuid& id) const
+{
+	auto course = Course::create();
+	course->setId(id);
+	course->setTitle(QStringLiteral("Course"));
+	course->setDescription(QStringLiteral("Description"));
+	return course;
+}
+
+/* A null id creates a new one */
+Lesson QueryPlanTest::createLesson(const QUuid& id) const
+{
+	Lesson lesson;
+	lesson.setId(id);
+	lesson.setTitle(QStringLiteral("Lesson"));
+	lesson.setNewChars(QStringLiteral("asdf"));
+	lesson.setText(QStringLiteral("asdf jklö"));
+	return lesson;
+}
+
+/* Get the detail column of the query plan of the given statement */
+QStringList QueryPlanTest::explain(const QString& statement, const QMap<QString, QVariant>& bindings)
+{
+	QStringList plan;
+
+	QSqlQuery q(QSqlDatabase::database());
+	q.setForwardOnly(true);
+
+	if (!q.prepare(QStringLiteral("EXPLAIN QUERY PLAN ") % statement))
+		throw DbException(QStringLiteral("Unable to prepare query plan"), q.lastError());
+
+	for (auto it = bindings.constBegin(); it != bindings.constEnd(); ++it)
+		q.bindValue(it.key(), it.value());
+
+	if (!q.exec())
+		throw DbException(QStringLiteral("Unable to explain query plan"), q.lastError());
+
+	// id, parent, notused, detail
+	while (q.next())
+		plan << q.value(3).toString();
+
+	return plan;
+}
+
+/* Get the first plan detail with a full scan that is not allowed or an empty string */
+QString QueryPlanTest::findScan(const QStringList& plan, const QStringList& allowedScans) const
+{
+	for (const auto& detail : plan)
+	{
+		auto match = fullScan.match(detail);
+		if (match.hasMatch() && !allowedScans.contains(match.captured(2)))
+			return detail;
+	}
+
+	return QString();
+}
+
+void QueryPlanTest::queryPlanTest_data()
+{
+	QTest::addColumn<QString>("statement");
+	// Tables that are searched completely by design
+	QTest::addColumn<QStringList>("allowedScans");
+
+	for (const auto& s : mStatements)
+	{
+		QStringList allowed;
+		// Every lesson has to be checked for references
+		if (s.first == QLatin1String("selectDanglingLesson"))
+			allowed << QStringLiteral("tblLesson") << QStringLiteral("tblLessonList");
+
+		QTest::newRow(qUtf8Printable(s.first)) << s.first << allowed;
+	}
+}
+
+void QueryPlanTest::queryPlanTest()
+{
+	QFETCH(QString, statement);
+	QFETCH(QStringList, allowedScans);
+
+	mObserved.clear();
+
+	std::vector<std::pair<QString, QStringList>> plans;
+	try
+	{
+		db->begin_transaction();
+		mStatements.at(statement)();
+		// Explain the executed statements
+		for (const auto& o : mObserved)
+			plans.push_back(std::make_pair(o.first, explain(o.first, o.second)));
+		db->rollback();
+	}
+	catch (DbException& e)
+	{
+		db->rollback();
+		QFAIL(qUtf8Printable(e.message()));
+	}
+
+	QVERIFY2(!plans.empty(), "Statement not observed");
+
+	for (const auto& p : plans)
+	{
+		QVERIFY(!p.second.isEmpty());
+
+		QString detail = findScan(p.second, allowedScans);
+		if (!detail.isEmpty())
+			QFAIL(qUtf8Printable(QStringLiteral("Full table scan in ") % statement % ": " % detail
+			                     % "\nQuery: " % p.first
+			                     % "\nPlan:\n  " % p.second.join(QStringLiteral("\n  "))));
+	}
+}
+
+void QueryPlanTest::triggerPlanTest_data()
+{
+	QTest::addColumn<QString>("statement");
+	QTest::addColumn<QVariantMap>("bindings");
+
+	QVariantMap bindings;
+	bindings.insert(":id", mLessonListId);
+	bindings.insert(":parentId", mLessonListId - 1);
+	bindings.insert(":childId", mLessonListId + 1);
+	bindings.insert(":courseId", DbV1::encodeUuid(mCourseId));
+	bindings.insert(":lessonId", DbV1::encodeUuid(mLessonId));
+	bindings.insert(":profile", mProfileName);
+
+	/* The bodies of the LessonList triggers with NEW and OLD replaced by bindings.
+	 * RAISE() cannot be explained outside of a trigger. */
+	QTest::newRow("LessonListBeforeInsert head")
+	        << QStringLiteral("SELECT 1 WHERE :parentId ISNULL AND (SELECT pkCourseUuid FROM tblCourse WHERE pkCourseUuid = :courseId) ISNULL")
+	        << bindings;
+	QTest::newRow("LessonListBeforeInsert course")
+	        << QStringLiteral("SELECT 1 WHERE :parentId NOTNULL AND (SELECT fkCourseUuid FROM tblLessonList WHERE pkLessonListId = :parentId) != :courseId")
+	        << bindings;
+	QTest::newRow("LessonListAfterInsert course")
+	        << QStringLiteral("UPDATE tblLessonList SET fkCourseUuid = (SELECT fkCourseUuid FROM tblLessonList WHERE pkLessonListId = :parentId) WHERE fkCourseUuid ISNULL")
+	        << bindings;
+	QTest::newRow("LessonListAfterInsert child")
+	        << QStringLiteral("UPDATE tblLessonList SET fkChildId = :id WHERE pkLessonListId = :parentId")
+	        << bindings;
+	QTest::newRow("LessonListAfterInsertHead parent")
+	        << QStringLiteral("UPDATE tblLessonList SET fkParentId = :id WHERE fkCourseUuid = :courseId AND fkParentId IS NULL AND pkLessonListId != :id")
+	        << bindings;
+	QTest::newRow("LessonListAfterInsertHead child")
+	        << QStringLiteral("UPDATE tblLessonList SET fkChildId = (SELECT pkLessonListId FROM tblLessonList WHERE fkParentId = :id) WHERE pkLessonListId = :id")
+	        << bindings;
+	QTest::newRow("LessonListBeforeChildIdUpdate when")
+	        << QStringLiteral("SELECT (SELECT count(*) FROM tblLessonList WHERE fkParentId = :id) > 1")
+	        << bindings;
+	QTest::newRow("LessonListBeforeChildIdUpdate parent")
+	        << QStringLiteral("UPDATE tblLessonList SET fkParentId = :childId WHERE pkLessonListId = :id")
+	        << bindings;
+	QTest::newRow("LessonListBeforeDelete child")
+	        << QStringLiteral("UPDATE tblLessonList SET fkChildId = :childId WHERE pkLessonListId = :parentId")
+	        << bindings;
+
+	/* The lookups of the foreign key actions on deletion of a referenced row */
+	QTest::newRow("tblCourse cascade")
+	        << QStringLiteral("DELETE FROM tblLessonList WHERE fkCourseUuid = :courseId")
+	        << bindings;
+	QTest::newRow("tblLesson cascade")
+	        << QStringLiteral("DELETE FROM tblLessonList WHERE fkLessonUuid = :lessonId")
+	        << bindings;
+	QTest::newRow("tblLessonList parent reference")
+	        << QStringLiteral("SELECT 1 FROM tblLessonList WHERE fkParentId = :id")
+	        << bindings;
+	QTest::newRow("tblLessonList child reference")
+	        << QStringLiteral("SELECT 1 FROM tblLessonList WHERE fkChildId = :id")
+	        << bindings;
+	QTest::newRow("tblLessonList stats cascade")
+	        << QStringLiteral("DELETE FROM tblStats WHERE pkfkLessonListId = :id")
+	        << bindings;
+	QTest::newRow("tblProfile stats cascade")
+	        << QStringLiteral("DELETE FROM tblStats WHERE pkfkProfileName = :profile")
+	        << bindings;
+}
+
+void QueryPlanTest::triggerPlanTest()
+{
+	QFETCH(QString, statement);
+	QFETCH(QVariantMap, bindings);
+
+	// Only the bindings used by the statement can be bound
+	QMap<QString, QVariant> used;
+	for (auto it = bindings.constBegin(); it != bindings.constEnd(); ++it)
+		if (statement.contains(QRegularExpression(QRegularExpression::escape(it.key()) % QStringLiteral("\\b"))))
+			used.insert(it.key(), it.value());
+
+	QStringList plan;
+	try
+	{
+		plan = explain(statement, used);
+	}
+	catch (DbException& e)
+	{
+		QFAIL(qUtf8Printable(e.message()));
+	}
+
+	QVERIFY(!plan.isEmpty());
+
+	QString detail = findScan(plan, QStringList());
+	if (!detail.isEmpty())
+		QFAIL(qUtf8Printable(QStringLiteral("Full table scan: ") % detail
+		                     % "\nPlan:\n  " % plan.join(QStringLiteral("\n  "))));
+}
+
+} /* namespace qtouch */
+
+QTEST_GUILESS_MAIN(qtouch::QueryPlanTest)
+#include "queryplan_test.moc"
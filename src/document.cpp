@@ -39,6 +39,9 @@ Document::Document(QObject* parent) :
 {
 	//	setUseDesignMetrics(true);
 
+	// The document is only rebuilt as a whole
+	setUndoRedoEnabled(false);
+
 	mTextBlockFormat.setLineHeight(200, QTextBlockFormat::ProportionalHeight);
 	mTextBlockFormat.setAlignment(Qt::AlignJustify);
 
@@ -57,6 +60,9 @@ Document::Document(QObject* parent) :
 	mTitleCharFormat.setFontPointSize(mTextCharFormat.fontPointSize() * 1.5);
 	mTitleCharFormat.setForeground(QColor("black"));
 	mTitleCharFormat.setBackground(Qt::transparent);
+
+	// Connected first to be invalidated before other receivers query the metrics
+	connect(this, &QTextDocument::contentsChanged, this, &Document::invalidateMetrics);
 }
 
 Document::~Document()
@@ -66,19 +72,73 @@ Document::~Document()
 void Document::setTitle(const QString& title)
 {
 	// Remove line breaks; prevent creation of multiple blocks
-	mTitle = title.simplified();
-	resetText();
+	QString simplified = title.simplified();
+	if (simplified == mTitle)
+		return;
 
-	emit titleChanged();
+	mTitle = simplified;
+	mTitlePending = true;
+	commit();
 }
 
 void Document::setText(const QString& text)
 {
 	/* TODO: Should we remove duplicated spaces from the given text? */
+	if (text == mText)
+		return;
+
 	mText = text;
+	mTextPending = true;
+	commit();
+}
+
+/**
+ * Set title and text with a single rebuild of the document.
+ * @param title The title.
+ * @param text The text.
+ */
+void Document::setContent(const QString& title, const QString& text)
+{
+	beginUpdate();
+	setTitle(title);
+	setText(text);
+	endUpdate();
+}
+
+/**
+ * Defer the rebuild of the document and the change signals until the
+ * matching endUpdate(). Calls may be nested.
+ */
+void Document::beginUpdate()
+{
+	++mUpdateDepth;
+}
+
+void Document::endUpdate()
+{
+	Q_ASSERT(mUpdateDepth > 0);
+	if (mUpdateDepth > 0 && --mUpdateDepth == 0)
+		commit();
+}
+
+/* Rebuild once and notify about everything changed since the last rebuild */
+void Document::commit()
+{
+	if (mUpdateDepth > 0 || (!mTitlePending && !mTextPending))
+		return;
+
+	bool notifyTitle = mTitlePending;
+	bool notifyText = mTextPending;
+	mTitlePending = false;
+	mTextPending = false;
+
 	resetText();
 
-	emit textChanged();
+	if (notifyTitle)
+		emit titleChanged();
+	if (notifyText)
+		emit textChanged();
+	emit contentChanged();
 }
 
 /**
@@ -103,36 +163,62 @@ QTextBlock Document::getFirstTextBlock()
 void Document::setTitleBlockFormat(const QTextBlockFormat& format)
 {
 	mTitleBlockFormat = format;
+	invalidateMetrics();
 }
 
 void Document::setTextBlockFormat(const QTextBlockFormat& format)
 {
 	mTextBlockFormat = format;
+	invalidateMetrics();
 }
 
 void Document::setTitleCharFormat(const QTextCharFormat& format)
 {
 	mTitleCharFormat = format;
+	invalidateMetrics();
 }
 
 void Document::setTextCharFormat(const QTextCharFormat& format)
 {
 	mTextCharFormat = format;
+	invalidateMetrics();
 }
 
+/**
+ * The width of the longest line plus margins.
+ * Needs two full layouts, so the result is cached until the content, a
+ * format, the document margin or the default font changes.
+ * @return The ideal width.
+ */
 qreal Document::getIdealWidth()
 {
-	qreal backup = textWidth();
-	setTextWidth(-1);
-	qreal result = idealWidth();
-	setTextWidth(backup);
-	return result;
+	if (mIdealWidthGeneration != mGeneration || mIdealWidthMargin != documentMargin()
+	        || mIdealWidthFont != defaultFont())
+	{
+		qreal backup = textWidth();
+		setTextWidth(-1);
+		mIdealWidth = idealWidth();
+		setTextWidth(backup);
+		mIdealWidthGeneration = mGeneration;
+		mIdealWidthMargin = documentMargin();
+		mIdealWidthFont = defaultFont();
+	}
+	return mIdealWidth;
+}
+
+void Document::invalidateMetrics()
+{
+	++mGeneration;
 }
 
 void Document::resetText()
 {
-	clear();
 	QTextCursor c(this);
+	// A single contentsChanged for the whole rebuild
+	c.beginEditBlock();
+
+	c.select(QTextCursor::Document);
+	c.removeSelectedText();
 
 	c.setBlockFormat(mTitleBlockFormat);
 	c.insertText(mTitle, mTitleCharFormat);
@@ -142,6 +228,8 @@ void Document::resetText()
 	c.setBlockFormat(mTextBlockFormat);
 	c.insertText(mText, mTextCharFormat);
 
+	c.endEditBlock();
+
 	Q_ASSERT(blockCount() >= 2);
 }
 
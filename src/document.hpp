@@ -29,6 +29,7 @@
 
 #include <memory>
 
+#include <QFont>
 #include <QObject>
 #include <QTextDocument>
 #include <QTextBlockFormat>
@@ -54,6 +55,10 @@ public:
 	inline QString getText() const { return mText; }
 	void setText(const QString& text);
 
+	Q_INVOKABLE void setContent(const QString& title, const QString& text);
+	void beginUpdate();
+	void endUpdate();
+
 	void setTitleBlockFormat(const QTextBlockFormat& format);
 	inline QTextBlockFormat getTitleBlockFormat() const { return mTitleBlockFormat; }
 	void setTextBlockFormat(const QTextBlockFormat& format);
@@ -65,6 +70,8 @@ public:
 	inline QTextCharFormat getTextCharFormat() const { return mTextCharFormat; }
 
 	qreal getIdealWidth();
+	/** Incremented on every change of the content or the formats. */
+	inline quint64 getGeneration() const { return mGeneration; }
 
 	std::unique_ptr<QTextCursor> getTextCursor();
 	QTextBlock getFirstTextBlock();
@@ -74,8 +81,13 @@ public:
 signals:
 	void titleChanged();
 	void textChanged();
+	/** Emitted once after the document was rebuilt. */
+	void contentChanged();
 
 protected:
+	void invalidateMetrics();
+	void commit();
+
 	QString mTitle;
 	QString mText;
 
@@ -83,6 +95,20 @@ protected:
 	QTextCharFormat mTextCharFormat;
 	QTextBlockFormat mTitleBlockFormat;
 	QTextCharFormat mTitleCharFormat;
+
+	/* Nesting depth of beginUpdate() */
+	int mUpdateDepth = 0;
+	bool mTitlePending = false;
+	bool mTextPending = false;
+
+	quint64 mGeneration = 0;
+	/* Generation, margin and default font mIdealWidth was computed for.
+	 * QTextDocument's margin and font setters are not virtual and QML sets
+	 * them through the property system, so they are compared directly. */
+	quint64 mIdealWidthGeneration = ~Q_UINT64_C(0);
+	qreal mIdealWidthMargin = -1;
+	QFont mIdealWidthFont;
+	qreal mIdealWidth = 0;
 };
 
 } /* namespace qtouch */
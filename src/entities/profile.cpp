@@ -26,6 +26,106 @@
 
 #include "profile.hpp"
 
+#include <stdexcept>
+
 namespace qtouch
 {
+
+void StatsStore::reserve(size_type n)
+{
+	mCourse.reserve(n);
+	mLesson.reserve(n);
+	mStart.reserve(n);
+	mTime.reserve(n);
+	mCharCount.reserve(n);
+	mErrorCount.reserve(n);
+}
+
+/** Remove all rows. The interned ids are kept since the same lessons are likely loaded again. */
+void StatsStore::clear()
+{
+	mCourse.clear();
+	mLesson.clear();
+	mStart.clear();
+	mTime.clear();
+	mCharCount.clear();
+	mErrorCount.clear();
+}
+
+/**
+ * Append a row.
+ * @param stats The Stats. Its profile name is not stored, the rows get the one of the store.
+ */
+void StatsStore::push_back(const Stats& stats)
+{
+	mCourse.push_back(intern(stats.getCourseId()));
+	mLesson.push_back(intern(stats.getLessonId()));
+	mStart.push_back(stats.getStart().toMSecsSinceEpoch());
+	mTime.push_back(stats.getTime());
+	mCharCount.push_back(stats.getCharCount());
+	mErrorCount.push_back(stats.getErrorCount());
+}
+
+/**
+ * Insert a row before the given position.
+ * Appending is the fast path, every other position moves all columns.
+ * @return An iterator to the inserted row.
+ */
+StatsStore::const_iterator StatsStore::insert(const_iterator pos, const Stats& stats)
+{
+	size_type index = pos.index();
+	if (index == size())
+	{
+		push_back(stats);
+		return const_iterator(this, index);
+	}
+
+	mCourse.insert(mCourse.begin() + index, intern(stats.getCourseId()));
+	mLesson.insert(mLesson.begin() + index, intern(stats.getLessonId()));
+	mStart.insert(mStart.begin() + index, stats.getStart().toMSecsSinceEpoch());
+	mTime.insert(mTime.begin() + index, stats.getTime());
+	mCharCount.insert(mCharCount.begin() + index, stats.getCharCount());
+	mErrorCount.insert(mErrorCount.begin() + index, stats.getErrorCount());
+
+	return const_iterator(this, index);
+}
+
+/** Materialize the row at the given index. */
+Stats StatsStore::operator[](size_type i) const
+{
+	Stats stats(mIds[mCourse[i]], mIds[mLesson[i]], mProfileName, QDateTime::fromMSecsSinceEpoch(mStart[i]));
+	stats.setTime(mTime[i]);
+	stats.setCharCount(mCharCount[i]);
+	stats.setErrorCount(mErrorCount[i]);
+	return stats;
+}
+
+Stats StatsStore::at(size_type i) const
+{
+	if (i >= size())
+		throw std::out_of_range("StatsStore index out of range");
+	return (*this)[i];
+}
+
+quint32 StatsStore::intern(const QUuid& id)
+{
+	auto it = mIdIndex.constFind(id);
+	if (it != mIdIndex.constEnd())
+		return it.value();
+
+	quint32 index = static_cast<quint32>(mIds.size());
+	mIds.push_back(id);
+	mIdIndex.insert(id, index);
+	return index;
+}
+
+/** Replace all Stats by the given ones. */
+void Profile::replace(const std::vector<Stats>& stats)
+{
+	mStats.clear();
+	mStats.reserve(stats.size());
+	for (const auto& s : stats)
+		mStats.push_back(s);
+}
+
 } /* namespace qtouch */
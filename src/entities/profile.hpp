@@ -27,9 +27,12 @@
 #ifndef PROFILE_HPP_
 #define PROFILE_HPP_
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
 #include <vector>
 #include <QDateTime>
+#include <QHash>
 #include <QString>
 #include <QUuid>
 
@@ -70,13 +73,143 @@ protected:
 	quint32 mErrorCount;
 };
 
+/**
+ * Column store of the Stats of one profile.
+ * Course and lesson ids are interned into a table and referenced by index,
+ * the start is stored as ms since epoch and the profile name only once. A
+ * session takes 28 bytes in six contiguous columns that can be scanned
+ * directly. Iteration yields Stats by value, so existing code keeps working
+ * as long as it does not modify the Stats through the iterator.
+ */
+class StatsStore
+{
+public:
+	typedef Stats value_type;
+	typedef std::size_t size_type;
+
+	/** Random access iterator that materializes the rows on dereference. */
+	class const_iterator
+	{
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef Stats value_type;
+		typedef std::ptrdiff_t difference_type;
+		/* Rows do not exist as objects */
+		typedef Stats reference;
+
+		/** Keeps the materialized row alive for operator->(). */
+		class pointer
+		{
+		public:
+			explicit pointer(const Stats& stats) : mStats(stats) {}
+			inline const Stats* operator->() const { return &mStats; }
+		private:
+			Stats mStats;
+		};
+
+		const_iterator() : mStore(nullptr), mIndex(0) {}
+		const_iterator(const StatsStore* store, size_type index) : mStore(store), mIndex(index) {}
+
+		inline size_type index() const { return mIndex; }
+
+		inline reference operator*() const { return (*mStore)[mIndex]; }
+		inline pointer operator->() const { return pointer((*mStore)[mIndex]); }
+		inline reference operator[](difference_type n) const { return (*mStore)[mIndex + n]; }
+
+		inline const_iterator& operator++() { ++mIndex; return *this; }
+		inline const_iterator operator++(int) { const_iterator tmp(*this); ++mIndex; return tmp; }
+		inline const_iterator& operator--() { --mIndex; return *this; }
+		inline const_iterator operator--(int) { const_iterator tmp(*this); --mIndex; return tmp; }
+		inline const_iterator& operator+=(difference_type n) { mIndex += n; return *this; }
+		inline const_iterator& operator-=(difference_type n) { mIndex -= n; return *this; }
+		inline const_iterator operator+(difference_type n) const { return const_iterator(mStore, mIndex + n); }
+		inline const_iterator operator-(difference_type n) const { return const_iterator(mStore, mIndex - n); }
+		inline difference_type operator-(const const_iterator& rhs) const
+		{
+			return static_cast<difference_type>(mIndex) - static_cast<difference_type>(rhs.mIndex);
+		}
+
+		inline bool operator==(const const_iterator& rhs) const { return mIndex == rhs.mIndex && mStore == rhs.mStore; }
+		inline bool operator!=(const const_iterator& rhs) const { return !(*this == rhs); }
+		inline bool operator<(const const_iterator& rhs) const { return mIndex < rhs.mIndex; }
+		inline bool operator>(const const_iterator& rhs) const { return mIndex > rhs.mIndex; }
+		inline bool operator<=(const const_iterator& rhs) const { return mIndex <= rhs.mIndex; }
+		inline bool operator>=(const const_iterator& rhs) const { return mIndex >= rhs.mIndex; }
+
+	private:
+		const StatsStore* mStore;
+		size_type mIndex;
+	};
+
+	explicit StatsStore(const QString& profileName = QString()) : mProfileName(profileName) {}
+
+	inline const QString& getProfileName() const { return mProfileName; }
+	inline void setProfileName(const QString& profileName) { mProfileName = profileName; }
+
+	inline size_type size() const { return mStart.size(); }
+	inline bool empty() const { return mStart.empty(); }
+
+	void reserve(size_type n);
+	void clear();
+	void push_back(const Stats& stats);
+	const_iterator insert(const_iterator pos, const Stats& stats);
+	template<typename InputIt>
+	const_iterator insert(const_iterator pos, InputIt first, InputIt last);
+
+	Stats operator[](size_type i) const;
+	Stats at(size_type i) const;
+
+	inline const_iterator begin() const { return const_iterator(this, 0); }
+	inline const_iterator end() const { return const_iterator(this, size()); }
+
+	// Columns
+
+	/** The id referenced by an entry of the course or lesson column. */
+	inline const QUuid& getId(quint32 index) const { return mIds.at(index); }
+	inline const std::vector<QUuid>& getIds() const { return mIds; }
+
+	inline const std::vector<quint32>& getCourseColumn() const { return mCourse; }
+	inline const std::vector<quint32>& getLessonColumn() const { return mLesson; }
+	/** Start in ms since epoch */
+	inline const std::vector<qint64>& getStartColumn() const { return mStart; }
+	inline const std::vector<quint32>& getTimeColumn() const { return mTime; }
+	inline const std::vector<quint32>& getCharCountColumn() const { return mCharCount; }
+	inline const std::vector<quint32>& getErrorCountColumn() const { return mErrorCount; }
+
+private:
+	quint32 intern(const QUuid& id);
+
+	QString mProfileName;
+
+	/* Interned ids of courses and lessons */
+	std::vector<QUuid> mIds;
+	QHash<QUuid, quint32> mIdIndex;
+
+	std::vector<quint32> mCourse;
+	std::vector<quint32> mLesson;
+	std::vector<qint64> mStart;
+	std::vector<quint32> mTime;
+	std::vector<quint32> mCharCount;
+	std::vector<quint32> mErrorCount;
+};
+
+template<typename InputIt>
+StatsStore::const_iterator StatsStore::insert(const_iterator pos, InputIt first, InputIt last)
+{
+	size_type index = pos.index();
+	for (size_type i = index; first != last; ++first, ++i)
+		insert(const_iterator(this, i), *first);
+	return const_iterator(this, index);
+}
+
 class Profile
 {
 public:
-	typedef std::vector<Stats>::value_type value_type;
-	typedef std::vector<Stats>::size_type size_type;
-	typedef std::vector<Stats>::iterator iterator;
-	typedef std::vector<Stats>::const_iterator const_iterator;
+	typedef StatsStore::value_type value_type;
+	typedef StatsStore::size_type size_type;
+	/* The Stats are only readable through iterators */
+	typedef StatsStore::const_iterator iterator;
+	typedef StatsStore::const_iterator const_iterator;
 
 	/** SkillLevel */
 	enum SkillLevel
@@ -85,7 +218,8 @@ public:
 		Advanced //!< Advanced
 	};
 
-	explicit Profile(const QString& name, SkillLevel skill = Beginner) : mName(name), mSkillLevel(skill) {}
+	explicit Profile(const QString& name, SkillLevel skill = Beginner) :
+		mName(name), mSkillLevel(skill), mStats(name) {}
 	virtual ~Profile() {}
 
 	inline const QString& getName() const { return mName; }
@@ -95,24 +229,24 @@ public:
 
 	inline void push_back(const Stats& stats) { mStats.push_back(stats); }
 	inline void clear() { mStats.clear(); }
-	inline void replace(std::vector<Stats> stats) { mStats.swap(stats); }
+	void replace(const std::vector<Stats>& stats);
 	inline size_type size() const { return mStats.size(); }
 
 	template<typename InputIt>
 	iterator insert(const_iterator pos, InputIt first, InputIt last) { return mStats.insert(pos, first, last); }
 	inline iterator insert(const_iterator position, const value_type& val) { return mStats.insert(position, val); }
-	inline iterator insert(const_iterator position, value_type&& val) { return mStats.insert(position, val); }
 
 	inline const_iterator begin() const { return mStats.begin(); }
 	inline const_iterator end() const { return mStats.end(); }
-	inline iterator begin() { return mStats.begin(); }
-	inline iterator end() { return mStats.end(); }
+
+	/** Columnar access for analytics over the whole history */
+	inline const StatsStore& getStats() const { return mStats; }
 
 protected:
 	QString mName;
 	SkillLevel mSkillLevel;
 
-	std::vector<Stats> mStats;
+	StatsStore mStats;
 };
 
 } /* namespace qtouch */
@@ -0,0 +1,210 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file profile_test.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+#include "profile.hpp"
+
+namespace qtouch
+{
+
+class ProfileTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+
+	void roundTrip();
+	void internIds();
+	void insert();
+	void inserter();
+	void columns();
+	void copy();
+	void replace();
+
+private:
+	Stats createStats(const QUuid& lessonId, int minutes, quint32 chars) const;
+
+	QUuid mCourseId;
+	QUuid mLessonId1;
+	QUuid mLessonId2;
+	QDateTime mStart;
+};
+
+void ProfileTest::init()
+{
+	mCourseId = QUuid::createUuid();
+	mLessonId1 = QUuid::createUuid();
+	mLessonId2 = QUuid::createUuid();
+	mStart = QDateTime(QDate(2016, 10, 18), QTime(12, 0));
+}
+
+Stats ProfileTest::createStats(const QUuid& lessonId, int minutes, quint32 chars) const
+{
+	Stats stats(mCourseId, lessonId, QStringLiteral("TestUser"), mStart.addSecs(minutes * 60));
+	stats.setTime(minutes * 1000);
+	stats.setCharCount(chars);
+	stats.setErrorCount(chars / 10);
+	return stats;
+}
+
+void ProfileTest::roundTrip()
+{
+	Profile profile(QStringLiteral("TestUser"));
+	profile.push_back(createStats(mLessonId1, 1, 100));
+	profile.push_back(createStats(mLessonId2, 2, 200));
+
+	QCOMPARE(profile.size(), static_cast<Profile::size_type>(2));
+
+	int minutes = 1;
+	for (const Stats& s : profile)
+	{
+		QCOMPARE(s.getCourseId(), mCourseId);
+		QCOMPARE(s.getLessonId(), minutes == 1 ? mLessonId1 : mLessonId2);
+		QCOMPARE(s.getProfileName(), QStringLiteral("TestUser"));
+		QCOMPARE(s.getStart(), mStart.addSecs(minutes * 60));
+		QCOMPARE(s.getTime(), static_cast<quint32>(minutes * 1000));
+		QCOMPARE(s.getCharCount(), static_cast<quint32>(minutes * 100));
+		QCOMPARE(s.getErrorCount(), static_cast<quint32>(minutes * 10));
+		++minutes;
+	}
+
+	QCOMPARE(profile.begin()->getLessonId(), mLessonId1);
+	QCOMPARE(profile.end() - profile.begin(), static_cast<std::ptrdiff_t>(2));
+	QVERIFY_EXCEPTION_THROWN(profile.getStats().at(2), std::out_of_range);
+
+	profile.clear();
+	QCOMPARE(profile.size(), static_cast<Profile::size_type>(0));
+	QVERIFY(profile.begin() == profile.end());
+}
+
+void ProfileTest::internIds()
+{
+	Profile profile(QStringLiteral("TestUser"));
+	for (int i = 0; i < 100; ++i)
+		profile.push_back(createStats(i % 2 ? mLessonId1 : mLessonId2, i, i));
+
+	// One course and two lessons
+	QCOMPARE(profile.getStats().getIds().size(), static_cast<std::size_t>(3));
+
+	const auto& lessons = profile.getStats().getLessonColumn();
+	QCOMPARE(profile.getStats().getId(lessons.at(0)), mLessonId2);
+	QCOMPARE(profile.getStats().getId(lessons.at(1)), mLessonId1);
+}
+
+void ProfileTest::insert()
+{
+	Profile profile(QStringLiteral("TestUser"));
+	profile.push_back(createStats(mLessonId1, 1, 100));
+	profile.push_back(createStats(mLessonId1, 3, 300));
+
+	auto it = profile.insert(profile.begin() + 1, createStats(mLessonId2, 2, 200));
+	QCOMPARE(it - profile.begin(), static_cast<std::ptrdiff_t>(1));
+	QCOMPARE(it->getLessonId(), mLessonId2);
+
+	quint32 expected = 100;
+	for (const Stats& s : profile)
+	{
+		QCOMPARE(s.getCharCount(), expected);
+		expected += 100;
+	}
+}
+
+/* DbHelper::getStats() fills the Profile through an insert iterator */
+void ProfileTest::inserter()
+{
+	std::vector<Stats> source;
+	for (int i = 0; i < 10; ++i)
+		source.push_back(createStats(mLessonId1, i, i));
+
+	Profile profile(QStringLiteral("TestUser"));
+	std::copy(source.begin(), source.end(), std::inserter(profile, profile.begin()));
+
+	QCOMPARE(profile.size(), source.size());
+	QVERIFY(std::equal(source.begin(), source.end(), profile.begin(), [](const Stats& lhs, const Stats& rhs)
+	{
+		return lhs.getStart() == rhs.getStart() && lhs.getCharCount() == rhs.getCharCount();
+	}));
+}
+
+void ProfileTest::columns()
+{
+	Profile profile(QStringLiteral("TestUser"));
+	for (int i = 1; i <= 10; ++i)
+		profile.push_back(createStats(mLessonId1, i, i * 10));
+
+	const StatsStore& stats = profile.getStats();
+	const auto& chars = stats.getCharCountColumn();
+	QCOMPARE(std::accumulate(chars.begin(), chars.end(), quint64(0)), quint64(550));
+
+	const auto& start = stats.getStartColumn();
+	QCOMPARE(start.front(), mStart.addSecs(60).toMSecsSinceEpoch());
+	QVERIFY(std::is_sorted(start.begin(), start.end()));
+}
+
+void ProfileTest::copy()
+{
+	Profile profile(QStringLiteral("TestUser"), Profile::Advanced);
+	profile.push_back(createStats(mLessonId1, 1, 100));
+
+	Profile copy(profile);
+	profile.clear();
+
+	QCOMPARE(copy.size(), static_cast<Profile::size_type>(1));
+	QCOMPARE(copy.begin()->getProfileName(), QStringLiteral("TestUser"));
+	QCOMPARE(copy.getSkillLevel(), Profile::Advanced);
+}
+
+void ProfileTest::replace()
+{
+	Profile profile(QStringLiteral("TestUser"));
+	for (int i = 0; i < 5; ++i)
+		profile.push_back(createStats(mLessonId1, i, i));
+
+	std::vector<Stats> stats { createStats(mLessonId2, 10, 100), createStats(mLessonId2, 11, 110) };
+	profile.replace(stats);
+
+	QCOMPARE(profile.size(), stats.size());
+	QVERIFY(std::equal(stats.begin(), stats.end(), profile.begin(), [](const Stats& lhs, const Stats& rhs)
+	{
+		return lhs.getLessonId() == rhs.getLessonId() && lhs.getStart() == rhs.getStart()
+		       && lhs.getCharCount() == rhs.getCharCount();
+	}));
+
+	profile.replace(std::vector<Stats>());
+	QCOMPARE(profile.size(), static_cast<Profile::size_type>(0));
+}
+
+} /* namespace qtouch */
+
+QTEST_GUILESS_MAIN(qtouch::ProfileTest)
+#include "profile_test.moc"
@@ -0,0 +1,148 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file asyncsvgelementprovider.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "asyncsvgelementprovider.hpp"
+
+#include <QRunnable>
+#include <QMetaObject>
+
+namespace qtouch
+{
+
+/* Delivers a single image to the QML engine */
+class SvgImageResponse : public QQuickImageResponse
+{
+	Q_OBJECT
+
+public:
+	QQuickTextureFactory* textureFactory() const Q_DECL_OVERRIDE
+	{
+		return QQuickTextureFactory::textureFactoryForImage(mImage);
+	}
+
+public slots:
+	void finish(const QImage& image)
+	{
+		mImage = image;
+		emit finished();
+	}
+
+private:
+	QImage mImage;
+};
+
+/* Rasterizes a request on the pool and notifies all responses that wait for it */
+class SvgRasterJob : public QObject, public QRunnable
+{
+	Q_OBJECT
+
+public:
+	SvgRasterJob(AsyncSvgElementProvider* provider, const SvgRasterizer::Request& request) :
+		mProvider(provider), mRequest(request)
+	{
+		// Deleted on the thread it lives in after done() was delivered
+		setAutoDelete(false);
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		QImage image = mProvider->mRasterizer.rasterize(mRequest, nullptr);
+
+		{
+			// Later requests hit the cache or start a new job
+			QMutexLocker lock(&mProvider->mInFlightMutex);
+			mProvider->mInFlight.erase(mRequest.key);
+		}
+
+		emit done(image);
+		deleteLater();
+	}
+
+signals:
+	void done(const QImage& image);
+
+private:
+	AsyncSvgElementProvider* mProvider;
+	SvgRasterizer::Request mRequest;
+};
+
+const char* AsyncSvgElementProvider::NAME = "svgelement";
+
+/**
+ * \brief Constructor
+ * \param base The base URL (should end with an "/"). Defaults to "qrc:///"
+ */
+AsyncSvgElementProvider::AsyncSvgElementProvider(const QUrl& base) :
+	mRasterizer(base)
+{
+	// Keep the threads and thereby their parsed SVGs alive
+	mPool.setExpiryTimeout(-1);
+}
+
+AsyncSvgElementProvider::~AsyncSvgElementProvider()
+{
+	mPool.waitForDone();
+}
+
+QQuickImageResponse* AsyncSvgElementProvider::requestImageResponse(const QString& id, const QSize& requestedSize)
+{
+	SvgImageResponse* response = new SvgImageResponse;
+	SvgRasterizer::Request request = mRasterizer.resolve(id, requestedSize);
+
+	QImage image;
+	if (!request.error.isEmpty())
+	{
+		// Placeholder is cheap
+		image = mRasterizer.rasterize(request, nullptr);
+	}
+	else if (!mRasterizer.lookup(request, &image, nullptr))
+	{
+		QMutexLocker lock(&mInFlightMutex);
+
+		// Join a running job. The job can't finish before we are connected while we hold the lock.
+		auto it = mInFlight.find(request.key);
+		if (it != mInFlight.end())
+		{
+			QObject::connect(it->second, &SvgRasterJob::done, response, &SvgImageResponse::finish);
+			return response;
+		}
+
+		SvgRasterJob* job = new SvgRasterJob(this, request);
+		QObject::connect(job, &SvgRasterJob::done, response, &SvgImageResponse::finish);
+		mInFlight[request.key] = job;
+		mPool.start(job);
+		return response;
+	}
+
+	// The engine connects to finished() after we return
+	QMetaObject::invokeMethod(response, "finish", Qt::QueuedConnection, Q_ARG(QImage, image));
+	return response;
+}
+
+} /* namespace qtouch */
+
+#include "asyncsvgelementprovider.moc"
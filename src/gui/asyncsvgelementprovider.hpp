@@ -0,0 +1,78 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file asyncsvgelementprovider.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef ASYNCSVGELEMENTPROVIDER_HPP_
+#define ASYNCSVGELEMENTPROVIDER_HPP_
+
+#include <map>
+
+#include <QQuickAsyncImageProvider>
+#include <QThreadPool>
+#include <QMutex>
+
+#include "svgelementprovider.hpp"
+
+namespace qtouch
+{
+
+class SvgRasterJob;
+
+/**
+ * \brief Asynchronous variant of the SvgElementProvider.
+ * Elements are rasterized on a private thread pool, so loading a screen with many
+ * images does not block the GUI thread. Cached images are delivered without touching
+ * the pool and concurrent requests of the same image share a single job.
+ */
+class AsyncSvgElementProvider : public QQuickAsyncImageProvider
+{
+	friend class SvgRasterJob;
+
+public:
+	/** The id the provider is added to the QML engine with. */
+	static const char* NAME;
+
+	explicit AsyncSvgElementProvider(const QUrl& base = QUrl(QStringLiteral("qrc:///")));
+	virtual ~AsyncSvgElementProvider();
+
+	QQuickImageResponse* requestImageResponse(const QString& id, const QSize& requestedSize) Q_DECL_OVERRIDE;
+
+	inline SvgRasterizer& getRasterizer() { return mRasterizer; }
+	inline QThreadPool& getThreadPool() { return mPool; }
+
+private:
+	SvgRasterizer mRasterizer;
+	QThreadPool mPool;
+
+	/* Guards mInFlight */
+	QMutex mInFlightMutex;
+	/* Image key -> Job that currently rasterizes it */
+	std::map<QString, SvgRasterJob*> mInFlight;
+};
+
+} /* namespace qtouch */
+
+#endif /* ASYNCSVGELEMENTPROVIDER_HPP_ */
@@ -0,0 +1,94 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file cursorgeometry.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/cursorgeometry.hpp"
+
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QAbstractTextDocumentLayout>
+
+namespace qtouch
+{
+
+/**
+ * Build the table.
+ * @param doc The document. Its layout must be up to date.
+ * @param textStart The document position of index 0.
+ */
+void CursorGeometry::build(const QTextDocument* doc, int textStart)
+{
+	mLines.clear();
+	mLineOf.clear();
+	mX.clear();
+
+	for (QTextBlock block = doc->findBlock(textStart); block.isValid(); block = block.next())
+	{
+		QTextLayout* layout = block.layout();
+		if (!layout || !layout->lineCount())
+			continue;
+
+		// Top left edge of the block
+		QPointF blockTopLeft = doc->documentLayout()->blockBoundingRect(block).topLeft();
+
+		for (int l = 0; l < layout->lineCount(); ++l)
+		{
+			QTextLine line = layout->lineAt(l);
+			mLines.push_back(Line { blockTopLeft.y() + line.y(), line.height(), block.blockNumber(),
+			                        block.position() - textStart });
+
+			// A position at a wrap belongs to the next line, the end of the block to the last one
+			int end = (l + 1 < layout->lineCount()) ? layout->lineAt(l + 1).textStart() : block.length();
+			for (int p = line.textStart(); p < end; ++p)
+			{
+				if (block.position() + p < textStart)
+					continue;
+				mLineOf.push_back(static_cast<int>(mLines.size()) - 1);
+				mX.push_back(blockTopLeft.x() + line.cursorToX(p));
+			}
+		}
+	}
+
+	mValid = true;
+}
+
+/**
+ * Lookup the cursor geometry.
+ * @param index The position relative to textStart. It's clamped to the text.
+ * @return The geometry.
+ */
+CursorGeometry::Position CursorGeometry::at(int index) const
+{
+	if (mX.empty())
+		return Position { QRectF(), 0, 0 };
+
+	index = qBound(0, index, static_cast<int>(mX.size()) - 1);
+	const Line& line = mLines[mLineOf[index]];
+	return Position { QRectF(mX[index], line.top, 1, line.height), line.blockNumber, index - line.blockStart };
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,82 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file cursorgeometry.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef CURSORGEOMETRY_HPP_
+#define CURSORGEOMETRY_HPP_
+
+#include <vector>
+#include <QRectF>
+
+class QTextDocument;
+
+namespace qtouch
+{
+
+/**
+ * Table of the cursor geometry for every position of a text in a laid out document.
+ * Building it queries the text layout once per position, afterwards every
+ * lookup is O(1). It must be rebuilt whenever the layout changes.
+ */
+class CursorGeometry
+{
+public:
+	struct Position
+	{
+		/** Cursor rectangle with a width of 1 in document coordinates */
+		QRectF rect;
+		int blockNumber;
+		int positionInBlock;
+	};
+
+	inline bool isValid() const { return mValid; }
+	inline void invalidate() { mValid = false; }
+
+	void build(const QTextDocument* doc, int textStart);
+	Position at(int index) const;
+
+private:
+	struct Line
+	{
+		/* Document coordinates of the line */
+		qreal top;
+		qreal height;
+		int blockNumber;
+		/* Index of the first position of the block */
+		int blockStart;
+	};
+
+	std::vector<Line> mLines;
+	/* Index -> Line */
+	std::vector<int> mLineOf;
+	/* Index -> x in document coordinates */
+	std::vector<qreal> mX;
+	bool mValid = false;
+};
+
+} /* namespace qtouch */
+
+#endif /* CURSORGEOMETRY_HPP_ */
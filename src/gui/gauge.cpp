@@ -0,0 +1,174 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file gauge.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/gauge.hpp"
+
+#include <QtMath>
+#include <QSGGeometryNode>
+#include <QSGFlatColorMaterial>
+
+namespace qtouch
+{
+
+namespace
+{
+
+/* Segments of the target mark */
+const int ARC_SEGMENTS = 48;
+
+/* Geometry of meter.svgz relative to the size of the dial */
+const qreal DIAL_OFFSET = 0.2;
+const qreal ARC_RADIUS = 0.85 / 2;
+const qreal ARC_WIDTH = 1.0 / 20;
+
+} /* namespace */
+
+Gauge::Gauge(QQuickItem* parent) :
+	SvgDial(parent)
+{
+	addLayer(QStringLiteral("background"), Background);
+	addLayer(QStringLiteral("ring"));
+	mArc = addCustomLayer();
+	addLayer(QStringLiteral("scale"), 0, 1, DIAL_OFFSET);
+	mHand = addLayer(QStringLiteral("hand"), Hand, 1, DIAL_OFFSET);
+
+	setSource(QUrl(QStringLiteral("qrc:///images/meter.svgz")));
+	updateHand();
+}
+
+Gauge::~Gauge()
+{
+}
+
+void Gauge::setCurrent(int current)
+{
+	if (current != mCurrent)
+	{
+		mCurrent = current;
+		updateHand();
+		emit currentChanged();
+	}
+}
+
+void Gauge::setTarget(int target)
+{
+	if (target != mTarget)
+	{
+		mTarget = target;
+		updateCustomLayers();
+		emit targetChanged();
+	}
+}
+
+void Gauge::setMin(int min)
+{
+	if (min != mMin)
+	{
+		mMin = min;
+		updateHand();
+		updateCustomLayers();
+		emit minChanged();
+	}
+}
+
+void Gauge::setMax(int max)
+{
+	if (max != mMax)
+	{
+		mMax = max;
+		updateHand();
+		updateCustomLayers();
+		emit maxChanged();
+	}
+}
+
+void Gauge::setTargetMarkColor(const QColor& color)
+{
+	if (color != mTargetMarkColor)
+	{
+		mTargetMarkColor = color;
+		updateCustomLayers();
+		emit targetMarkColorChanged();
+	}
+}
+
+/* The hand covers 90° from -45° to 45° */
+void Gauge::updateHand()
+{
+	int range = qAbs(mMax - mMin);
+	qreal fraction = range ? qMin(qreal(mCurrent) / range, qreal(1)) : 0;
+	setAngle(mHand, fraction * 90 - 45);
+}
+
+QSGNode* Gauge::updateCustomNode(int layer, QSGNode* oldNode)
+{
+	Q_ASSERT(layer == mArc);
+	Q_UNUSED(layer);
+
+	QSGGeometryNode* node = static_cast<QSGGeometryNode*>(oldNode);
+	if (!node)
+	{
+		QSGGeometry* geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 2 * (ARC_SEGMENTS + 1));
+		geometry->setDrawingMode(GL_TRIANGLE_STRIP);
+
+		node = new QSGGeometryNode();
+		node->setGeometry(geometry);
+		node->setFlag(QSGNode::OwnsGeometry);
+		node->setMaterial(new QSGFlatColorMaterial());
+		node->setFlag(QSGNode::OwnsMaterial);
+	}
+
+	static_cast<QSGFlatColorMaterial*>(node->material())->setColor(mTargetMarkColor);
+
+	// The mark runs counterclockwise from the end of the scale to the target
+	const int min = qMin(mMin, mMax);
+	const int max = qMax(mMin, mMax);
+	const int target = qBound(min, mTarget, max);
+	const qreal fraction = (max > min) ? qMax(1 - qreal(target) / (max - min), qreal(0)) : 0;
+	const qreal start = qDegreesToRadians(-45.0);
+	const qreal sweep = qDegreesToRadians(-fraction * 90);
+
+	const QRectF dial = dialRect();
+	const QPointF centre(dial.center().x(), dial.center().y() + DIAL_OFFSET * dial.width());
+	const qreal inner = (ARC_RADIUS - ARC_WIDTH / 2) * dial.width();
+	const qreal outer = (ARC_RADIUS + ARC_WIDTH / 2) * dial.width();
+
+	QSGGeometry::Point2D* v = node->geometry()->vertexDataAsPoint2D();
+	for (int i = 0; i <= ARC_SEGMENTS; ++i)
+	{
+		qreal a = start + sweep * i / ARC_SEGMENTS;
+		qreal c = qCos(a);
+		qreal s = qSin(a);
+		v[2 * i].set(centre.x() + inner * c, centre.y() + inner * s);
+		v[2 * i + 1].set(centre.x() + outer * c, centre.y() + outer * s);
+	}
+
+	node->markDirty(QSGNode::DirtyGeometry | QSGNode::DirtyMaterial);
+	return node;
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,97 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file gauge.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef GAUGE_HPP_
+#define GAUGE_HPP_
+
+#include <QColor>
+
+#include "gui/svgdial.hpp"
+
+namespace qtouch
+{
+
+/**
+ * Meter with a hand for the current value and an arc that marks the target.
+ * The layers of meter.svgz are rasterized once per size. A new value only
+ * rotates the hand and a new target only recalculates the vertices of the arc.
+ */
+class Gauge: public SvgDial
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int current READ getCurrent WRITE setCurrent NOTIFY currentChanged)
+	Q_PROPERTY(int target READ getTarget WRITE setTarget NOTIFY targetChanged)
+	Q_PROPERTY(int min READ getMin WRITE setMin NOTIFY minChanged)
+	Q_PROPERTY(int max READ getMax WRITE setMax NOTIFY maxChanged)
+	Q_PROPERTY(QColor targetMarkColor READ getTargetMarkColor WRITE setTargetMarkColor NOTIFY targetMarkColorChanged)
+
+public:
+	explicit Gauge(QQuickItem* parent = nullptr);
+	virtual ~Gauge();
+
+	inline int getCurrent() const { return mCurrent; }
+	void setCurrent(int current);
+
+	inline int getTarget() const { return mTarget; }
+	void setTarget(int target);
+
+	inline int getMin() const { return mMin; }
+	void setMin(int min);
+
+	inline int getMax() const { return mMax; }
+	void setMax(int max);
+
+	inline QColor getTargetMarkColor() const { return mTargetMarkColor; }
+	void setTargetMarkColor(const QColor& color);
+
+signals:
+	void currentChanged();
+	void targetChanged();
+	void minChanged();
+	void maxChanged();
+	void targetMarkColorChanged();
+
+protected:
+	virtual QSGNode* updateCustomNode(int layer, QSGNode* oldNode) Q_DECL_OVERRIDE;
+
+private:
+	void updateHand();
+
+	int mCurrent = 0;
+	int mTarget = 0;
+	int mMin = 0;
+	int mMax = 100;
+	QColor mTargetMarkColor = QColor(0x50, 0xFF, 0x3C);
+
+	int mArc;
+	int mHand;
+};
+
+} /* namespace qtouch */
+
+#endif /* GAUGE_HPP_ */
@@ -0,0 +1,217 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file latencymonitor.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/latencymonitor.hpp"
+
+#include <QFile>
+#include <QTextStream>
+#include <QQuickWindow>
+#include <QDebug>
+
+#include "utils/diagnostics.hpp"
+
+namespace qtouch
+{
+
+namespace
+{
+
+/* 0.25 ms buckets up to 250 ms */
+const qint64 BUCKET_WIDTH_NS = 250000;
+const int BUCKETS = 1000;
+
+const int RESERVED_INPUTS = 64;
+
+} /* namespace */
+
+const char* LatencyMonitor::ENV_VAR = "QTOUCH_LATENCY";
+
+LatencyMonitor::LatencyMonitor(QObject* parent) :
+	QObject(parent), mEnabled(false), mHistogram(BUCKET_WIDTH_NS, BUCKETS)
+{
+	mClock.start();
+	mPending.reserve(RESERVED_INPUTS);
+	mInFlight.reserve(RESERVED_INPUTS);
+
+	mEnabled = diagnostics::isEnabled(ENV_VAR);
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+	if (getCount())
+		diagnostics::report(ENV_VAR, report());
+}
+
+void LatencyMonitor::setEnabled(bool enabled)
+{
+	if (enabled != mEnabled)
+	{
+		mEnabled = enabled;
+		setWindow(mWindow);
+		emit enabledChanged();
+	}
+}
+
+/**
+ * Set the window whose frames are observed.
+ * @param window The window or nullptr.
+ */
+void LatencyMonitor::setWindow(QQuickWindow* window)
+{
+	if (mWindow)
+		disconnect(mWindow, nullptr, this, nullptr);
+
+	mWindow = window;
+
+	QMutexLocker lock(&mMutex);
+	mPending.clear();
+	mInFlight.clear();
+
+	// Timestamps are taken on the render thread
+	if (mWindow && mEnabled)
+	{
+		connect(mWindow, &QQuickWindow::beforeSynchronizing, this, &LatencyMonitor::onBeforeSynchronizing,
+		        Qt::DirectConnection);
+		connect(mWindow, &QQuickWindow::frameSwapped, this, &LatencyMonitor::onFrameSwapped, Qt::DirectConnection);
+	}
+}
+
+/**
+ * Record an input event that changes what is drawn.
+ * Inputs that change nothing must not be marked, they would wait for an unrelated frame.
+ * @param timestamp The arrival of the event as returned by timestamp().
+ */
+void LatencyMonitor::markInput(qint64 timestamp)
+{
+	if (!mEnabled || !mWindow)
+		return;
+
+	QMutexLocker lock(&mMutex);
+	mPending.push_back(timestamp);
+}
+
+void LatencyMonitor::reset()
+{
+	{
+		QMutexLocker lock(&mMutex);
+		mHistogram.clear();
+	}
+	emit updated();
+}
+
+int LatencyMonitor::getCount() const
+{
+	QMutexLocker lock(&mMutex);
+	return static_cast<int>(mHistogram.count());
+}
+
+qreal LatencyMonitor::getMax() const
+{
+	QMutexLocker lock(&mMutex);
+	return mHistogram.max() / 1e6;
+}
+
+qreal LatencyMonitor::percentile(double p) const
+{
+	QMutexLocker lock(&mMutex);
+	return mHistogram.percentile(p) / 1e6;
+}
+
+/**
+ * Format the results.
+ * @return A single line with the count and the latencies in ms.
+ */
+QString LatencyMonitor::report() const
+{
+	QMutexLocker lock(&mMutex);
+	return QString("Input latency: count %1 mean %2 p50 %3 p95 %4 p99 %5 max %6 ms")
+	       .arg(mHistogram.count())
+	       .arg(mHistogram.mean() / 1e6, 0, 'f', 2)
+	       .arg(mHistogram.percentile(0.5) / 1e6, 0, 'f', 2)
+	       .arg(mHistogram.percentile(0.95) / 1e6, 0, 'f', 2)
+	       .arg(mHistogram.percentile(0.99) / 1e6, 0, 'f', 2)
+	       .arg(mHistogram.max() / 1e6, 0, 'f', 2);
+}
+
+/**
+ * Append the results to a file.
+ * @param fileName The name of the file.
+ * @return true on success.
+ */
+bool LatencyMonitor::dump(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+	{
+		qWarning() << "Unable to dump latencies to" << fileName << ":" << file.errorString();
+		return false;
+	}
+
+	QTextStream s(&file);
+	s << report() << "\n";
+	return true;
+}
+
+void LatencyMonitor::publish()
+{
+	{
+		QMutexLocker lock(&mMutex);
+		mPublishQueued = false;
+	}
+	emit updated();
+}
+
+/* Render thread, GUI thread blocked */
+void LatencyMonitor::onBeforeSynchronizing()
+{
+	QMutexLocker lock(&mMutex);
+	mInFlight.insert(mInFlight.end(), mPending.cbegin(), mPending.cend());
+	mPending.clear();
+}
+
+/* Render thread */
+void LatencyMonitor::onFrameSwapped()
+{
+	qint64 now = mClock.nsecsElapsed();
+
+	QMutexLocker lock(&mMutex);
+	if (mInFlight.empty())
+		return;
+
+	for (qint64 t : mInFlight)
+		mHistogram.add(now - t);
+	mInFlight.clear();
+
+	// Notify on the GUI thread
+	if (!mPublishQueued)
+	{
+		mPublishQueued = true;
+		QMetaObject::invokeMethod(this, "publish", Qt::QueuedConnection);
+	}
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,120 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file latencymonitor.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef LATENCYMONITOR_HPP_
+#define LATENCYMONITOR_HPP_
+
+#include <vector>
+
+#include <QObject>
+#include <QPointer>
+#include <QMutex>
+#include <QElapsedTimer>
+
+#include "utils/histogram.hpp"
+
+class QQuickWindow;
+
+namespace qtouch
+{
+
+/**
+ * Measures the latency from a key event to the swap of the first frame that
+ * was synchronized after it.
+ * Inputs are taken over at beforeSynchronizing and resolved at frameSwapped,
+ * both on the render thread. So a frame that was already rendering when the
+ * key arrived isn't counted.\n
+ * Disabled by default. It is enabled by setting QTOUCH_LATENCY to 1, which
+ * prints the results with qInfo() on destruction, or to a file name to append
+ * them to (see diagnostics::report()).
+ */
+class LatencyMonitor: public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+	Q_PROPERTY(int count READ getCount NOTIFY updated)
+	/* Latencies in ms */
+	Q_PROPERTY(qreal p50 READ getP50 NOTIFY updated)
+	Q_PROPERTY(qreal p95 READ getP95 NOTIFY updated)
+	Q_PROPERTY(qreal p99 READ getP99 NOTIFY updated)
+	Q_PROPERTY(qreal max READ getMax NOTIFY updated)
+
+public:
+	/** Name of the environment variable that enables the monitor. */
+	static const char* ENV_VAR;
+
+	explicit LatencyMonitor(QObject* parent = nullptr);
+	virtual ~LatencyMonitor();
+
+	inline bool isEnabled() const { return mEnabled; }
+	void setEnabled(bool enabled);
+
+	int getCount() const;
+	inline qreal getP50() const { return percentile(0.5); }
+	inline qreal getP95() const { return percentile(0.95); }
+	inline qreal getP99() const { return percentile(0.99); }
+	qreal getMax() const;
+
+	void setWindow(QQuickWindow* window);
+	inline qint64 timestamp() const { return mClock.nsecsElapsed(); }
+	inline void markInput() { markInput(timestamp()); }
+	void markInput(qint64 timestamp);
+
+	Q_INVOKABLE void reset();
+	Q_INVOKABLE QString report() const;
+	Q_INVOKABLE bool dump(const QString& fileName) const;
+
+signals:
+	void enabledChanged();
+	void updated();
+
+private slots:
+	void publish();
+
+private:
+	qreal percentile(double p) const;
+	void onBeforeSynchronizing();
+	void onFrameSwapped();
+
+	bool mEnabled;
+	QPointer<QQuickWindow> mWindow;
+	QElapsedTimer mClock;
+
+	/* Guards everything below. Accessed by the GUI and the render thread. */
+	mutable QMutex mMutex;
+	/* Timestamps of inputs that are not yet part of a frame */
+	std::vector<qint64> mPending;
+	/* Timestamps of inputs that are part of the frame being rendered */
+	std::vector<qint64> mInFlight;
+	Histogram mHistogram;
+	bool mPublishQueued = false;
+};
+
+} /* namespace qtouch */
+
+#endif /* LATENCYMONITOR_HPP_ */
@@ -27,6 +27,7 @@ FocusScope {
     property var courseModel
     property var profileModel
     property alias document: lessonSelector.document
+    property alias profileScreenLoader: profileLoader
 
     signal lessonStarted
     Component.onCompleted: {
@@ -35,7 +36,7 @@ FocusScope {
 
     // Forward keys to the selectors as long as the ProfileScreen isn't enabled
     Keys.forwardTo: [courseSelector, lessonSelector]
-    Keys.enabled: !profileScreen.open
+    Keys.enabled: !btProfile.checked
 
     ToolBar {
         id: toolBar
@@ -90,7 +91,7 @@ FocusScope {
                 topMargin: 5
             }
 
-            focus: !profileScreen.open
+            focus: !btProfile.checked
 
             courseModel: root.courseModel
         } // courseSelector
@@ -133,9 +134,10 @@ FocusScope {
         } // lessonSelector
     } // container
 
-    ProfileScreen {
-        id: profileScreen
+    Items.ScreenLoader {
+        id: profileLoader
 
+        name: "ProfileScreen"
         anchors {
             top: toolBar.bottom
             right: root.right
@@ -144,16 +146,26 @@ FocusScope {
         }
 
         focus: btProfile.checked
-        open: btProfile.checked
+        required: btProfile.checked
 
-        profileModel: root.profileModel
+        sourceComponent: ProfileScreen {
+            id: profileScreen
 
-        // React to output signals
-        onCreateProfile: {
-            console.log("Creating profile: " + name + " (" + skilllevel + ")")
-            root.profileModel.addProfile(name, skilllevel)
-        }
-    } // profileScreen
+            anchors.fill: parent
+            focus: true
+            open: btProfile.checked
+            // Profiles are inserted by the DataModel once it is ready
+            creationEnabled: $dataModel.ready
+
+            profileModel: root.profileModel
+
+            // React to output signals
+            onCreateProfile: {
+                console.log("Creating profile: " + name + " (" + skilllevel + ")")
+                root.profileModel.addProfile(name, skilllevel)
+            }
+        } // profileScreen
+    } // profileLoader
 
     Connections {
         target: root.profileModel
@@ -21,9 +21,10 @@ import QtQuick.Window 2.1
 import QtQuick.Controls 1.3
 
 import de.nisble.qtouch 1.0
+import "items" as Items
 
 Window {
-    //    id: mainWindow
+    id: mainWindow
     width: 1250
     height: 700
     //    color: "transparent"
@@ -33,9 +34,47 @@ Window {
     onActiveFocusItemChanged: console.debug(
                                   "Active focus given to: " + activeFocusItem)
 
-    minimumWidth: trainingScreen.implicitWidth
+    minimumWidth: trainingLoader.item ? trainingLoader.item.implicitWidth : 0
     minimumHeight: 500
 
+    // Each document is rebuilt once per lesson instead of once for title and once for text
+    property QtObject lesson: $courseModel.lessonModel.lesson
+    onLessonChanged: {
+        var title = lesson ? lesson.title : ""
+        var text = lesson ? lesson.text : ""
+        homeScreen.document.setContent(title, text)
+        if (trainingLoader.item)
+            trainingLoader.item.document.setContent(title, text)
+    }
+
+    // Screens that are not needed for the first frame are incubated
+    // one after the other when the window is idle
+    property bool firstFrameSwapped: false
+    onFrameSwapped: {
+        if (!firstFrameSwapped) {
+            firstFrameSwapped = true
+            preloadTimer.start()
+        }
+    }
+
+    Timer {
+        id: preloadTimer
+        interval: 100
+        repeat: true
+        onTriggered: {
+            var screens = [trainingLoader, homeScreen.profileScreenLoader]
+            for (var i = 0; i < screens.length; i++) {
+                if (!screens[i].active) {
+                    screens[i].preloaded = true
+                    return
+                }
+                if (!screens[i].ready)
+                    return
+            }
+            stop()
+        }
+    }
+
     Flipable {
         id: flipper
 
@@ -55,39 +94,44 @@ Window {
             // Controlled by transition
             visible: true
             enabled: visible
-            focus: !trainingScreen.focus
+            focus: !trainingLoader.focus
 
             courseModel: $courseModel
             profileModel: $profileModel
-            document {
-                title: $courseModel.lessonModel.lesson.title
-                text: $courseModel.lessonModel.lesson.text
-                documentMargin: 30
-            }
+            document.documentMargin: 30
 
             onLessonStarted: flipper.state = "TRAINING"
         } // homeScreen
 
-        back: TrainingScreen {
-            id: trainingScreen
+        back: Items.ScreenLoader {
+            id: trainingLoader
 
+            name: "TrainingScreen"
             anchors.fill: parent
 
             // Controlled by transition
             visible: false
             enabled: visible
             focus: visible
+            required: flipper.state === "TRAINING"
 
-            onVisibleChanged: reset()
+            sourceComponent: TrainingScreen {
+                id: trainingScreen
 
-            document {
-                title: $courseModel.lessonModel.lesson.title
-                text: $courseModel.lessonModel.lesson.text
-                documentMargin: 40
-            }
+                anchors.fill: parent
+                focus: true
+
+                onVisibleChanged: reset()
 
-            onQuit: flipper.state = ""
-        } // trainingScreen
+                document.documentMargin: 40
+                Component.onCompleted: {
+                    if (mainWindow.lesson)
+                        document.setContent(mainWindow.lesson.title, mainWindow.lesson.text)
+                }
+
+                onQuit: flipper.state = ""
+            } // trainingScreen
+        } // trainingLoader
 
         transform: Rotation {
             id: rotation
@@ -112,7 +156,7 @@ Window {
                 to: "TRAINING"
                 SequentialAnimation {
                     PropertyAction {
-                        target: trainingScreen
+                        target: trainingLoader
                         property: "visible"
                         value: true
                     }
@@ -144,7 +188,7 @@ Window {
                         duration: 500
                     }
                     PropertyAction {
-                        target: trainingScreen
+                        target: trainingLoader
                         property: "visible"
                         value: false
                     }
@@ -163,8 +207,15 @@ Window {
 
         Row {
             anchors.fill: parent
+            spacing: 10
             Label {
-                text: "Read Only"
+                text: $dataModel.ready ? "Read Only" : $dataModel.status
+            }
+            // Courses show up while they are loaded
+            ProgressBar {
+                visible: !$dataModel.ready
+                height: parent.height
+                value: $dataModel.progress
             }
         }
     } // statusBar
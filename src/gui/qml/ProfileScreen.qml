@@ -29,6 +29,8 @@ FocusScope {
     property bool open: false
     // Set profile model
     property alias profileModel: profileList.model
+    // Disable while the profiles are loaded
+    property bool creationEnabled: true
 
     signal createProfile(string name, int skilllevel)
 
@@ -210,6 +212,7 @@ FocusScope {
                             horizontalCenter: parent.horizontalCenter
                         }
                         text: qsTr("Create Profile")
+                        enabled: root.creationEnabled
                         onClicked: {
                             createProfile(txtProfileName.text, 0)
                         }
@@ -225,6 +225,25 @@ FocusScope {
                     //                    }
                 } // widgetBackground
             } // widgetScroller
+
+            // Debug overlay, enabled by QTOUCH_LATENCY
+            Text {
+                id: latencyOverlay
+
+                property QtObject latency: trainingWidget.latency
+
+                anchors {
+                    top: parent.top
+                    right: parent.right
+                    margins: 4
+                }
+                visible: latency.enabled
+                color: "dimgray"
+                font.pixelSize: 12
+                text: qsTr("Key to frame (%1): p50 %2 ms  p95 %3 ms  p99 %4 ms").arg(
+                          latency.count).arg(latency.p50.toFixed(1)).arg(
+                          latency.p95.toFixed(1)).arg(latency.p99.toFixed(1))
+            }
         } // widgetContainer
     } // Column
 
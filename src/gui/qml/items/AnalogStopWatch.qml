@@ -17,6 +17,7 @@
 ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 **/
 import QtQuick 2.3
+import QtQuick.Window 2.2
 
 /*
 Analog stopwatch
@@ -28,8 +29,9 @@ Item {
 
     // Configuration
     property bool bgVisible: false
-    property int sourceWidth: 512
-    property int sourceHeight: 512
+    // Rasterize the layers at the device pixel size they are shown at
+    property int sourceWidth: Math.max(1, Math.ceil(Math.min(width, height) * Screen.devicePixelRatio))
+    property int sourceHeight: sourceWidth
 
     // Timer properties
     property alias interval: timer.interval
@@ -16,7 +16,7 @@
 ** along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **/
 import QtQuick 2.0
-import QtGraphicalEffects 1.0
+import de.nisble.qtouch 1.0
 
 Item {
     id: root
@@ -25,91 +25,39 @@ Item {
     property int shAnimationTime: 1000
     property int mhAnimationTime: 0
     property bool continuousMinuteHand: false
-    property bool showBackground: false
+    property alias showBackground: stopWatch.showBackground
 
-    Image {
-        id: background
+    // Face and hands are drawn natively.
+    // Animating an angle only changes the transform of a hand.
+    StopWatch {
+        id: stopWatch
         anchors.fill: parent
-        visible: showBackground
-        sourceSize.width: 1024
-        sourceSize.height: 1024
-        fillMode: Image.PreserveAspectFit
-        source: "image://svgelement/clock.svgz#background"
-    }
-
-    Image {
-        id: face
-        anchors.fill: parent
-        sourceSize.width: 1024
-        sourceSize.height: 1024
-        fillMode: Image.PreserveAspectFit
-        source: "image://svgelement/clock.svgz#face"
-    }
-
-    DropShadow {
-        id: minutehand
-        anchors.centerIn: face
-        width: face.width * 0.85
-        height: face.height * 0.85
-
-        source: Image {
-            sourceSize.width: 1024
-            sourceSize.height: 1024
-            fillMode: Image.PreserveAspectFit
-            source: "image://svgelement/clock.svgz#minute-hand"
-            visible: false
-        }
-
-        color: "black"
-        radius: 1.5
-        samples: 4
-        spread: 0
 
         property int min: seconds / 60
         onMinChanged: {
             if (!continuousMinuteHand)
-                rotation = min * 6
+                minuteAngle = min * 6
         }
 
-        Behavior on rotation {
+        secondAngle: seconds * 6
+
+        Behavior on minuteAngle {
             NumberAnimation {
                 easing.type: Easing.InQuad
                 duration: mhAnimationTime
             }
         }
-    }
 
-    onSecondsChanged: {
-        if (continuousMinuteHand)
-            minutehand.rotation = seconds / 60 * 6
-    }
-
-    DropShadow {
-        id: secondhand
-        anchors.centerIn: face
-        width: face.width * 0.85
-        height: face.height * 0.85
-
-        source: Image {
-            sourceSize.width: 1024
-            sourceSize.height: 1024
-            fillMode: Image.PreserveAspectFit
-            source: "image://svgelement/clock.svgz#second-hand"
-            visible: false
-        }
-
-        color: "black"
-        radius: 1.5
-        samples: 4
-        spread: 0
-
-        rotation: seconds * 6
-
-        Behavior on rotation {
+        Behavior on secondAngle {
             NumberAnimation {
                 easing.type: Easing.InQuad
                 duration: shAnimationTime
             }
         }
     }
+
+    onSecondsChanged: {
+        if (continuousMinuteHand)
+            stopWatch.minuteAngle = seconds / 60 * 6
+    }
 }
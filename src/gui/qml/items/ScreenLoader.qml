@@ -0,0 +1,71 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+**
+** This file is part of QTouch.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published
+** by the Free Software Foundation, either version 3 of the License,
+** or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**/
+import QtQuick 2.3
+
+/*
+Loader for screens that are incubated asynchronously.
+A screen is created when it is required or when it is preloaded in idle time.
+A required screen that is still incubating is completed synchronously.
+The time from the activation to the ready screen is stored in loadTime.
+ */
+Loader {
+    id: root
+
+    // Configuration
+    property string name
+    // Set when the screen is needed right now
+    property bool required: false
+    // Set to incubate the screen in idle time. Latched once the screen was required,
+    // so it is kept when it is not required anymore.
+    property bool preloaded: false
+
+    // Output
+    property int loadTime: -1
+    readonly property bool ready: status === Loader.Ready
+
+    property double activatedAt: 0
+
+    active: required || preloaded
+    asynchronous: !required
+
+    onRequiredChanged: {
+        if (required)
+            preloaded = true
+    }
+
+    onActiveChanged: {
+        if (active && activatedAt === 0)
+            activatedAt = Date.now()
+    }
+    Component.onCompleted: {
+        if (required)
+            preloaded = true
+        if (active && activatedAt === 0)
+            activatedAt = Date.now()
+    }
+
+    onStatusChanged: {
+        if (status === Loader.Ready && loadTime < 0) {
+            loadTime = activatedAt > 0 ? Date.now() - activatedAt : 0
+            console.debug("Screen " + name + " ready after " + loadTime + " ms"
+                          + (required ? "" : " (preloaded)"))
+        } else if (status === Loader.Error) {
+            console.warn("Unable to load screen " + name)
+        }
+    }
+}
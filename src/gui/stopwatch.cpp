@@ -0,0 +1,82 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file stopwatch.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/stopwatch.hpp"
+
+namespace qtouch
+{
+
+namespace
+{
+
+/* Size of the hands relative to the face */
+const qreal HAND_SCALE = 0.85;
+
+} /* namespace */
+
+StopWatch::StopWatch(QQuickItem* parent) :
+	SvgDial(parent)
+{
+	addLayer(QStringLiteral("background"), Background);
+	addLayer(QStringLiteral("face"));
+	mMinuteHand = addLayer(QStringLiteral("minute-hand"), Hand, HAND_SCALE);
+	mSecondHand = addLayer(QStringLiteral("second-hand"), Hand, HAND_SCALE);
+
+	setSource(QUrl(QStringLiteral("qrc:///images/clock.svgz")));
+}
+
+StopWatch::~StopWatch()
+{
+}
+
+void StopWatch::setMinuteAngle(qreal degrees)
+{
+	if (degrees != mMinuteAngle)
+	{
+		mMinuteAngle = degrees;
+		setAngle(mMinuteHand, degrees);
+		emit minuteAngleChanged();
+	}
+}
+
+void StopWatch::setSecondAngle(qreal degrees)
+{
+	if (degrees != mSecondAngle)
+	{
+		mSecondAngle = degrees;
+		setAngle(mSecondHand, degrees);
+		emit secondAngleChanged();
+	}
+}
+
+/* No custom layers */
+QSGNode* StopWatch::updateCustomNode(int, QSGNode* oldNode)
+{
+	return oldNode;
+}
+
+} /* namespace qtouch */
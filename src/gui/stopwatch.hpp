@@ -0,0 +1,75 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file stopwatch.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef STOPWATCH_HPP_
+#define STOPWATCH_HPP_
+
+#include "gui/svgdial.hpp"
+
+namespace qtouch
+{
+
+/**
+ * Clock face with a minute and a second hand.
+ * The layers of clock.svgz are rasterized once per size. The angles of the
+ * hands are properties, so they can be animated without repainting anything.
+ */
+class StopWatch: public SvgDial
+{
+	Q_OBJECT
+
+	Q_PROPERTY(qreal minuteAngle READ getMinuteAngle WRITE setMinuteAngle NOTIFY minuteAngleChanged)
+	Q_PROPERTY(qreal secondAngle READ getSecondAngle WRITE setSecondAngle NOTIFY secondAngleChanged)
+
+public:
+	explicit StopWatch(QQuickItem* parent = nullptr);
+	virtual ~StopWatch();
+
+	inline qreal getMinuteAngle() const { return mMinuteAngle; }
+	void setMinuteAngle(qreal degrees);
+
+	inline qreal getSecondAngle() const { return mSecondAngle; }
+	void setSecondAngle(qreal degrees);
+
+signals:
+	void minuteAngleChanged();
+	void secondAngleChanged();
+
+protected:
+	virtual QSGNode* updateCustomNode(int layer, QSGNode* oldNode) Q_DECL_OVERRIDE;
+
+private:
+	qreal mMinuteAngle = 0;
+	qreal mSecondAngle = 0;
+
+	int mMinuteHand;
+	int mSecondHand;
+};
+
+} /* namespace qtouch */
+
+#endif /* STOPWATCH_HPP_ */
@@ -0,0 +1,129 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file svgatlas.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/svgatlas.hpp"
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringBuilder>
+
+#include <QDebug>
+
+namespace qtouch
+{
+
+namespace
+{
+
+const char* ATLAS_IMAGE = ":/atlas/svgatlas.png";
+const char* ATLAS_INDEX = ":/atlas/svgatlas.index";
+
+/* Prefix of the paths of files in the resources */
+const QLatin1String RESOURCE_PREFIX(":/");
+
+} /* namespace */
+
+const SvgAtlas& SvgAtlas::instance()
+{
+	static const SvgAtlas atlas(QString::fromLatin1(ATLAS_IMAGE), QString::fromLatin1(ATLAS_INDEX));
+	return atlas;
+}
+
+/**
+ * Load an atlas.
+ * Missing files result in an empty atlas.
+ * @param imageFile The image with all sprites.
+ * @param indexFile The index written by the atlasbuilder.
+ */
+SvgAtlas::SvgAtlas(const QString& imageFile, const QString& indexFile)
+{
+	QFile index(indexFile);
+	if (!index.exists())
+		return;
+
+	if (!index.open(QIODevice::ReadOnly | QIODevice::Text) || !mImage.load(imageFile))
+	{
+		qWarning() << "Unable to load SVG atlas" << imageFile;
+		return;
+	}
+
+	// Must match the format of the textures created by the rasterizer
+	if (mImage.format() != QImage::Format_ARGB32_Premultiplied)
+		mImage = mImage.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+	QTextStream s(&index);
+	while (!s.atEnd())
+	{
+		QStringList fields = s.readLine().split(' ', QString::SkipEmptyParts);
+		if (fields.size() != 8)
+			continue;
+
+		Sprite sprite;
+		sprite.rect = QRect(fields.at(4).toInt(), fields.at(5).toInt(), fields.at(2).toInt(), fields.at(3).toInt());
+		sprite.itemSize = QSize(fields.at(6).toInt(), fields.at(7).toInt());
+
+		if (!mImage.rect().contains(sprite.rect))
+		{
+			qWarning() << "Invalid sprite in SVG atlas:" << fields.at(0) << fields.at(1);
+			continue;
+		}
+
+		mSprites[key(fields.at(0), fields.at(1), sprite.rect.size())] = sprite;
+	}
+}
+
+/**
+ * Find a pre-rasterized element.
+ * @param path The file name of the SVG, usually a resource path like ":/images/meter.svgz".
+ * @param elementId The id of the element.
+ * @param size The exact size of the image.
+ * @param itemSize Receives the size of the element in the SVG. May be null.
+ * @return The image or a null image. The image references the memory of the atlas.
+ */
+QImage SvgAtlas::find(const QString& path, const QString& elementId, const QSize& size, QSize* itemSize) const
+{
+	if (mSprites.empty() || !path.startsWith(RESOURCE_PREFIX))
+		return QImage();
+
+	auto it = mSprites.find(key(path.mid(RESOURCE_PREFIX.size()), elementId, size));
+	if (it == mSprites.end())
+		return QImage();
+
+	if (itemSize)
+		*itemSize = it->second.itemSize;
+
+	const QRect& r = it->second.rect;
+	return QImage(mImage.constScanLine(r.y()) + r.x() * 4, r.width(), r.height(), mImage.bytesPerLine(),
+	              mImage.format());
+}
+
+QString SvgAtlas::key(const QString& name, const QString& elementId, const QSize& size)
+{
+	return name % '#' % elementId % '@' % QString::number(size.width()) % 'x' % QString::number(size.height());
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,74 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file svgatlas.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SVGATLAS_HPP_
+#define SVGATLAS_HPP_
+
+#include <map>
+
+#include <QImage>
+#include <QString>
+
+namespace qtouch
+{
+
+/**
+ * SVG elements that were rasterized at build time by the atlasbuilder tool.
+ * All sprites are stored in a single image. Found sprites share the memory
+ * of the atlas, so serving them costs neither rendering nor copying.\n
+ * The atlas is read only after loading and can be used from any thread.
+ */
+class SvgAtlas
+{
+public:
+	/** The atlas built into the resources. Empty if it wasn't built. */
+	static const SvgAtlas& instance();
+
+	SvgAtlas(const QString& imageFile, const QString& indexFile);
+
+	inline bool isEmpty() const { return mSprites.empty(); }
+	inline std::size_t size() const { return mSprites.size(); }
+
+	QImage find(const QString& path, const QString& elementId, const QSize& size, QSize* itemSize = nullptr) const;
+
+private:
+	struct Sprite
+	{
+		QRect rect;
+		QSize itemSize;
+	};
+
+	static QString key(const QString& name, const QString& elementId, const QSize& size);
+
+	QImage mImage;
+	/* Resource name, element and size -> Sprite */
+	std::map<QString, Sprite> mSprites;
+};
+
+} /* namespace qtouch */
+
+#endif /* SVGATLAS_HPP_ */
@@ -0,0 +1,478 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file svgdial.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/svgdial.hpp"
+#include "gui/svgelementprovider.hpp"
+#include "gui/asyncsvgelementprovider.hpp"
+
+#include <QtMath>
+#include <QPainter>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSGTransformNode>
+#include <QSGSimpleTextureNode>
+
+namespace qtouch
+{
+
+namespace
+{
+
+/* Radius of the shadow of the hands in device independent pixels */
+const qreal SHADOW_RADIUS = 1.5;
+
+/* Bake a cheap blurred shadow under the element */
+QImage addShadow(const QImage& element, qreal radius)
+{
+	QImage shadow(element.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+	QPainter shadowPainter(&shadow);
+	shadowPainter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+	shadowPainter.fillRect(shadow.rect(), Qt::black);
+	shadowPainter.end();
+
+	QImage image(element.size(), QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+	painter.setOpacity(0.25);
+	for (int dx = -1; dx <= 1; dx += 2)
+		for (int dy = -1; dy <= 1; dy += 2)
+			painter.drawImage(QPointF(dx * radius, dy * radius), shadow);
+	painter.setOpacity(1);
+	painter.drawImage(0, 0, element);
+
+	return image;
+}
+
+} /* namespace */
+
+/* Rasterizes the layers of a dial on a thread pool and hands them back at once */
+class SvgDialJob : public QObject, public QRunnable
+{
+	Q_OBJECT
+
+public:
+	struct Task
+	{
+		/* Invalid for layers without an image */
+		SvgRasterizer::Request request;
+		/* Shadow radius in pixels or 0 */
+		qreal shadow;
+	};
+
+	SvgDialJob(SvgRasterizer* rasterizer, int generation, const std::vector<Task>& tasks) :
+		mRasterizer(rasterizer), mGeneration(generation), mTasks(tasks)
+	{
+		// Deleted on the thread it lives in after done() was delivered
+		setAutoDelete(false);
+	}
+
+	void run() Q_DECL_OVERRIDE
+	{
+		QVector<QImage> images;
+		images.reserve(static_cast<int>(mTasks.size()));
+
+		for (const Task& task : mTasks)
+		{
+			QImage image;
+			if (!task.request.key.isEmpty() && !mRasterizer->lookup(task.request, &image, nullptr))
+				image = mRasterizer->rasterize(task.request, nullptr);
+
+			if (!image.isNull() && task.shadow > 0)
+				image = addShadow(image, task.shadow);
+
+			images.append(image);
+		}
+
+		emit done(mGeneration, images);
+		deleteLater();
+	}
+
+signals:
+	void done(int generation, const QVector<QImage>& images);
+
+private:
+	SvgRasterizer* mRasterizer;
+	int mGeneration;
+	std::vector<Task> mTasks;
+};
+
+SvgDial::SvgDial(QQuickItem* parent) :
+	QQuickItem(parent)
+{
+	setFlag(ItemHasContents, true);
+}
+
+SvgDial::~SvgDial()
+{
+}
+
+void SvgDial::setSource(const QUrl& source)
+{
+	if (source == mSource)
+		return;
+
+	mSource = source;
+	mImagesDirty = true;
+
+	polish();
+	emit sourceChanged();
+}
+
+void SvgDial::setShowBackground(bool show)
+{
+	if (show == mShowBackground)
+		return;
+
+	mShowBackground = show;
+	mImagesDirty = true;
+	polish();
+	emit showBackgroundChanged();
+}
+
+/**
+ * Add a layer that shows an element of the SVG.
+ * Must be called in the constructor of the subclass.
+ * @param elementId The id of the element.
+ * @param flags A combination of LayerFlags.
+ * @param scale The size of the layer relative to the dial.
+ * @param offsetY The vertical offset of the layer relative to the size of the dial.
+ * @return The index of the layer.
+ */
+int SvgDial::addLayer(const QString& elementId, int flags, qreal scale, qreal offsetY)
+{
+	mLayers.push_back(Layer { elementId, flags, scale, offsetY, 0, 0, QImage(), nullptr, nullptr });
+	return static_cast<int>(mLayers.size()) - 1;
+}
+
+/**
+ * Add a layer whose node is provided by updateCustomNode().
+ * Must be called in the constructor of the subclass.
+ * @return The index of the layer.
+ */
+int SvgDial::addCustomLayer()
+{
+	mLayers.push_back(Layer { QString(), 0, 1, 0, 0, 0, QImage(), nullptr, nullptr });
+	return static_cast<int>(mLayers.size()) - 1;
+}
+
+/**
+ * Rotate a hand on the next frame.
+ * @param layer The index of the layer.
+ * @param degrees The clockwise angle.
+ */
+void SvgDial::setAngle(int layer, qreal degrees)
+{
+	Layer& l = mLayers.at(layer);
+	if (l.angle == degrees)
+		return;
+
+	l.angle = degrees;
+	mAnglesDirty = true;
+	update();
+}
+
+/** Call updateCustomNode() for all custom layers on the next frame. */
+void SvgDial::updateCustomLayers()
+{
+	mCustomDirty = true;
+	update();
+}
+
+/** The largest square that fits into the item, in item coordinates */
+QRectF SvgDial::dialRect() const
+{
+	qreal side = qMin(width(), height());
+	return QRectF((width() - side) / 2, (height() - side) / 2, side, side);
+}
+
+void SvgDial::geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry)
+{
+	QQuickItem::geometryChanged(newGeometry, oldGeometry);
+
+	if (newGeometry.size() != oldGeometry.size())
+	{
+		// The textures are scaled until the next size bucket is reached
+		mGeometryDirty = true;
+		mCustomDirty = true;
+		update();
+		polish();
+	}
+}
+
+void SvgDial::itemChange(ItemChange change, const ItemChangeData& value)
+{
+	QQuickItem::itemChange(change, value);
+
+	// The device pixel ratio depends on the screen
+	if (change == ItemDevicePixelRatioHasChanged || (change == ItemSceneChange && value.window))
+		polish();
+}
+
+void SvgDial::updatePolish()
+{
+	const qreal side = dialRect().width() * (window() ? window()->effectiveDevicePixelRatio() : 1);
+
+	// Snapped like the SvgElementProvider does to share its cache and to hit the SvgAtlas
+	std::vector<int> sizes;
+	sizes.reserve(mLayers.size());
+	bool changed = mImagesDirty;
+	for (const Layer& layer : mLayers)
+	{
+		int size = 0;
+		bool hidden = (layer.flags & Background) && !mShowBackground;
+		if (!layer.elementId.isEmpty() && !hidden)
+			size = qMax(0, SvgRasterizer::snapSize(QSize(qCeil(side * layer.scale), qCeil(side * layer.scale))).width());
+
+		changed = changed || size != layer.size;
+		sizes.push_back(size);
+	}
+
+	if (!changed)
+		return;
+
+	attachRasterizer();
+	mImagesDirty = false;
+
+	std::vector<SvgDialJob::Task> tasks;
+	tasks.reserve(mLayers.size());
+	for (std::size_t i = 0; i < mLayers.size(); ++i)
+	{
+		Layer& layer = mLayers[i];
+		layer.size = sizes[i];
+
+		SvgDialJob::Task task { SvgRasterizer::Request(), 0 };
+		if (layer.size > 0)
+		{
+			QUrl url(mSource);
+			url.setFragment(layer.elementId);
+			task.request = mRasterizer->resolve(url.toString(), QSize(layer.size, layer.size));
+
+			if (layer.flags & Hand)
+				task.shadow = SHADOW_RADIUS * layer.size / qMax<qreal>(1, dialRect().width() * layer.scale);
+		}
+		tasks.push_back(task);
+	}
+
+	// The current textures are shown until the job is done
+	SvgDialJob* job = new SvgDialJob(mRasterizer, ++mGeneration, tasks);
+	connect(job, &SvgDialJob::done, this, &SvgDial::swapImages);
+	mPool->start(job);
+}
+
+/* Take the images of the last rasterization and recreate the textures */
+void SvgDial::swapImages(int generation, const QVector<QImage>& images)
+{
+	if (generation != mGeneration || images.size() != static_cast<int>(mLayers.size()))
+		return;
+
+	for (std::size_t i = 0; i < mLayers.size(); ++i)
+		mLayers[i].image = images.at(static_cast<int>(i));
+
+	mRebuild = true;
+	update();
+}
+
+/* Use the rasterizer of the image provider of the engine or a shared one without provider */
+void SvgDial::attachRasterizer()
+{
+	if (mRasterizer)
+		return;
+
+	QQmlEngine* engine = qmlEngine(this);
+	AsyncSvgElementProvider* provider = engine ? dynamic_cast<AsyncSvgElementProvider*>(
+	                                        engine->imageProvider(QLatin1String(AsyncSvgElementProvider::NAME))) : nullptr;
+	if (provider)
+	{
+		mRasterizer = &provider->getRasterizer();
+		mPool = &provider->getThreadPool();
+	}
+	else
+	{
+		static SvgRasterizer rasterizer { QUrl() };
+		mRasterizer = &rasterizer;
+		mPool = QThreadPool::globalInstance();
+	}
+}
+
+QSGNode* SvgDial::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*)
+{
+	QSGNode* root = oldNode;
+	if (!root)
+	{
+		root = new QSGNode();
+		mRebuild = true;
+	}
+
+	if (mRebuild)
+	{
+		// Children are owned by their parent
+		while (QSGNode* child = root->firstChild())
+		{
+			root->removeChildNode(child);
+			delete child;
+		}
+
+		for (int i = 0; i < static_cast<int>(mLayers.size()); ++i)
+		{
+			Layer& layer = mLayers[i];
+			layer.node = nullptr;
+			layer.transform = nullptr;
+
+			if (layer.elementId.isEmpty())
+			{
+				layer.node = updateCustomNode(i, nullptr);
+				if (layer.node)
+					root->appendChildNode(layer.node);
+				continue;
+			}
+
+			if (layer.image.isNull())
+				continue;
+
+			QSGSimpleTextureNode* node = new QSGSimpleTextureNode();
+			node->setTexture(window()->createTextureFromImage(layer.image));
+			node->setOwnsTexture(true);
+			node->setFiltering(QSGTexture::Linear);
+			layer.node = node;
+
+			if (layer.flags & Hand)
+			{
+				layer.transform = new QSGTransformNode();
+				layer.transform->appendChildNode(node);
+				root->appendChildNode(layer.transform);
+			}
+			else
+			{
+				root->appendChildNode(node);
+			}
+			updateGeometry(layer);
+		}
+
+		mRebuild = false;
+		mGeometryDirty = false;
+		mAnglesDirty = false;
+		mCustomDirty = false;
+		return root;
+	}
+
+	if (mGeometryDirty)
+	{
+		for (Layer& layer : mLayers)
+		{
+			if (!layer.elementId.isEmpty() && layer.node)
+				updateGeometry(layer);
+		}
+		mGeometryDirty = false;
+		mAnglesDirty = false;
+	}
+
+	if (mAnglesDirty)
+	{
+		for (Layer& layer : mLayers)
+		{
+			if (layer.transform)
+				updateTransform(layer);
+		}
+		mAnglesDirty = false;
+	}
+
+	if (mCustomDirty)
+	{
+		for (int i = 0; i < static_cast<int>(mLayers.size()); ++i)
+		{
+			Layer& layer = mLayers[i];
+			if (!layer.elementId.isEmpty())
+				continue;
+
+			QSGNode* node = updateCustomNode(i, layer.node);
+			if (node == layer.node)
+				continue;
+
+			// Keep the order of the layers
+			if (layer.node)
+			{
+				if (node)
+					root->insertChildNodeBefore(node, layer.node);
+				root->removeChildNode(layer.node);
+				delete layer.node;
+			}
+			else if (node)
+			{
+				QSGNode* before = nullptr;
+				for (int j = i + 1; j < static_cast<int>(mLayers.size()) && !before; ++j)
+					before = mLayers[j].transform ? mLayers[j].transform : mLayers[j].node;
+				if (before)
+					root->insertChildNodeBefore(node, before);
+				else
+					root->appendChildNode(node);
+			}
+			layer.node = node;
+		}
+		mCustomDirty = false;
+	}
+
+	return root;
+}
+
+/* Place the texture of an image layer in the dial */
+void SvgDial::updateGeometry(Layer& layer) const
+{
+	const QRectF dial = dialRect();
+	const qreal side = dial.width() * layer.scale;
+
+	QSGSimpleTextureNode* node = static_cast<QSGSimpleTextureNode*>(layer.node);
+	if (layer.transform)
+	{
+		// Positioned by the transform
+		node->setRect(QRectF(-side / 2, -side / 2, side, side));
+		updateTransform(layer);
+	}
+	else
+	{
+		node->setRect(QRectF(dial.center().x() - side / 2, dial.center().y() - side / 2
+		                     + layer.offsetY * dial.width(), side, side));
+	}
+}
+
+void SvgDial::updateTransform(Layer& layer) const
+{
+	const QRectF dial = dialRect();
+
+	QMatrix4x4 m;
+	m.translate(dial.center().x(), dial.center().y() + layer.offsetY * dial.width());
+	m.rotate(layer.angle, 0, 0, 1);
+	layer.transform->setMatrix(m);
+}
+
+} /* namespace qtouch */
+
+#include "svgdial.moc"
@@ -0,0 +1,155 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file svgdial.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SVGDIAL_HPP_
+#define SVGDIAL_HPP_
+
+#include <vector>
+
+#include <QQuickItem>
+#include <QImage>
+#include <QVector>
+#include <QUrl>
+
+class QSGTransformNode;
+class QSGSimpleTextureNode;
+class QThreadPool;
+
+namespace qtouch
+{
+
+class SvgRasterizer;
+
+/**
+ * Base class of dials that are composed of elements of a single SVG.
+ * The layers are rasterized once per snapped size into textures in the order they were added.
+ * Rasterizing happens on the thread pool of the AsyncSvgElementProvider and shares its
+ * image cache. The textures are swapped in when all layers are done.
+ * Hands are placed in transform nodes, so changing their angle only changes a matrix.
+ * Custom layers are provided by subclasses, e.g. for geometry that depends on a value.
+ * Elements that were pre-rasterized into the SvgAtlas are not rendered at all.\n
+ * All layers fill the largest square that fits into the item, like an Image with
+ * PreserveAspectFit does.
+ */
+class SvgDial: public QQuickItem
+{
+	Q_OBJECT
+
+	Q_PROPERTY(QUrl source READ getSource WRITE setSource NOTIFY sourceChanged)
+	Q_PROPERTY(bool showBackground READ getShowBackground WRITE setShowBackground NOTIFY showBackgroundChanged)
+
+public:
+	explicit SvgDial(QQuickItem* parent = nullptr);
+	virtual ~SvgDial();
+
+	inline QUrl getSource() const { return mSource; }
+	void setSource(const QUrl& source);
+
+	inline bool getShowBackground() const { return mShowBackground; }
+	void setShowBackground(bool show);
+
+signals:
+	void sourceChanged();
+	void showBackgroundChanged();
+
+protected:
+	enum LayerFlag
+	{
+		/** Only shown if showBackground is set */
+		Background = 0x1,
+		/** Rotated around the center of the layer, drawn with a shadow */
+		Hand = 0x2
+	};
+
+	int addLayer(const QString& elementId, int flags = 0, qreal scale = 1, qreal offsetY = 0);
+	int addCustomLayer();
+
+	void setAngle(int layer, qreal degrees);
+	void updateCustomLayers();
+
+	QRectF dialRect() const;
+
+	/**
+	 * Create or update the node of a custom layer.
+	 * Called on the render thread while the GUI thread is blocked.
+	 * @param layer The index returned by addCustomLayer().
+	 * @param oldNode The node returned by the last call or nullptr.
+	 * @return The node. Ownership is taken by the scene graph.
+	 */
+	virtual QSGNode* updateCustomNode(int layer, QSGNode* oldNode) = 0;
+
+	virtual void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) Q_DECL_OVERRIDE;
+	virtual void itemChange(ItemChange change, const ItemChangeData& value) Q_DECL_OVERRIDE;
+	virtual void updatePolish() Q_DECL_OVERRIDE;
+	virtual QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) Q_DECL_OVERRIDE;
+
+private slots:
+	void swapImages(int generation, const QVector<QImage>& images);
+
+private:
+	struct Layer
+	{
+		/* Empty for custom layers */
+		QString elementId;
+		int flags;
+		/* Relative to the size of the dial */
+		qreal scale;
+		qreal offsetY;
+		qreal angle;
+		/* Snapped side of the image in pixels, 0 if it isn't shown */
+		int size;
+		/* Kept to be able to recreate the nodes */
+		QImage image;
+		/* Render thread */
+		QSGNode* node;
+		QSGTransformNode* transform;
+	};
+
+	void attachRasterizer();
+	void updateGeometry(Layer& layer) const;
+	void updateTransform(Layer& layer) const;
+
+	QUrl mSource;
+	bool mShowBackground = false;
+
+	/* Shared with the image provider of the engine */
+	SvgRasterizer* mRasterizer = nullptr;
+	QThreadPool* mPool = nullptr;
+	/* Incremented per rasterization, images of older ones are dropped */
+	int mGeneration = 0;
+
+	std::vector<Layer> mLayers;
+	bool mImagesDirty = true;
+	bool mRebuild = true;
+	bool mGeometryDirty = false;
+	bool mAnglesDirty = false;
+	bool mCustomDirty = false;
+};
+
+} /* namespace qtouch */
+
+#endif /* SVGDIAL_HPP_ */
@@ -25,17 +25,24 @@
  */
 
 #include "svgelementprovider.hpp"
+#include "svgatlas.hpp"
 
 #include <algorithm>
+#include <iterator>
 
 #include <QQmlFile>
 #include <QSvgRenderer>
 #include <QPainter>
 #include <QFont>
 #include <QFontDatabase>
+#include <QTextStream>
+#include <QStringBuilder>
+#include <QtMath>
 
 #include <QDebug>
 
+#include "utils/diagnostics.hpp"
+
 namespace qtouch
 {
 
@@ -70,48 +77,146 @@ QImage placeholder(const QString& string, const QSize& size = QSize(200, 200))
 	return image;
 }
 
-} // namespace
+/* Rasterized images are kept up to this size */
+const std::size_t DEFAULT_IMAGE_CACHE_BUDGET = 64 * 1024 * 1024;
+
+/* The larger dimension of a requested size is rounded up to one of these */
+const int SIZE_BUCKETS[] = { 32, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048 };
+
+} /* namespace */
+
+const char* SvgRasterizer::ENV_VAR = "QTOUCH_SVG_STATS";
+
+SvgRasterizer::SvgRasterizer(const QUrl& base) :
+	mBaseUrl(base), mImages(DEFAULT_IMAGE_CACHE_BUDGET), mAtlasHits(0)
+{
+}
+
+SvgRasterizer::~SvgRasterizer()
+{
+	if (diagnostics::isEnabled(ENV_VAR))
+		diagnostics::report(ENV_VAR, report());
+}
 
 /**
- * \brief Constructor
- * \param type QQmlImageProviderBase::Image (default) or QQmlImageProviderBase::Pixmap
- * \param base The base URL (should end with an "/"). Defaults to "qrc:///"
+ * \brief Snap a size to the next larger size bucket while keeping its aspect ratio.
+ * Images are scaled down by the consuming item, so they never lose sharpness.
+ * Sizes above the largest bucket and empty dimensions are kept.
+ * \param size The requested size.
+ * \return The snapped size.
  */
-SvgElementProvider::SvgElementProvider(QQmlImageProviderBase::ImageType type, const QUrl& base):
-	QQuickImageProvider(type), mBaseUrl(base)
+QSize SvgRasterizer::snapSize(const QSize& size)
 {
+	int extent = std::max(size.width(), size.height());
+	if (extent <= 0)
+		return size;
+
+	const int* bucket = std::lower_bound(std::begin(SIZE_BUCKETS), std::end(SIZE_BUCKETS), extent);
+	if (bucket == std::end(SIZE_BUCKETS) || *bucket == extent)
+		return size;
+
+	qreal factor = qreal(*bucket) / extent;
+	return QSize(size.width() > 0 ? qCeil(size.width() * factor) : size.width(),
+	             size.height() > 0 ? qCeil(size.height() * factor) : size.height());
 }
 
-QImage SvgElementProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+/**
+ * \brief Resolve the requested URL.
+ * \param id The URL relative to the base URL with an optional element fragment.
+ * \param requestedSize The requested size. Empty dimensions are taken from the SVG.
+ * \return The request.
+ */
+SvgRasterizer::Request SvgRasterizer::resolve(const QString& id, const QSize& requestedSize) const
 {
+	Request request;
+	request.requestedSize = snapSize(requestedSize);
+
 	// Resolve URL
 	QUrl url = QUrl(id);
 	if (url.isRelative() && !mBaseUrl.isEmpty())
 		url = mBaseUrl.resolved(url);
 
 	if (!url.isValid())
-		return placeholder(QString("Invalid URL\nBase: %1\nInput: %2").arg(mBaseUrl.toString()).arg(id), requestedSize);
+	{
+		request.error = QString("Invalid URL\nBase: %1\nInput: %2").arg(mBaseUrl.toString()).arg(id);
+		return request;
+	}
 
 	// Make a filename from the given URL
-	QString imagepath = QQmlFile::urlToLocalFileOrQrc(url);
+	request.path = QQmlFile::urlToLocalFileOrQrc(url);
 	// Fragment is used to specify SVG element
-	QString elementId = url.fragment();
+	request.elementId = url.fragment();
+
+	request.key = QString("%1#%2@%3x%4").arg(request.path).arg(request.elementId)
+	              .arg(request.requestedSize.width()).arg(request.requestedSize.height());
+	return request;
+}
+
+/**
+ * \brief Get a rasterized image from the atlas or the cache.
+ * \param request The request.
+ * \param image Receives the image.
+ * \param size Receives the size of the image or element in the SVG. May be null.
+ * \return true on a hit.
+ */
+bool SvgRasterizer::lookup(const Request& request, QImage* image, QSize* size)
+{
+	if (!request.error.isEmpty())
+		return false;
+
+	// Pre-rasterized at build time
+	if (!request.elementId.isEmpty())
+	{
+		QImage sprite = SvgAtlas::instance().find(request.path, request.elementId, request.requestedSize, size);
+		if (!sprite.isNull())
+		{
+			++mAtlasHits;
+			*image = sprite;
+			return true;
+		}
+	}
+
+	QMutexLocker lock(&mMutex);
+	const CachedImage* cached = mImages.get(request.key);
+	if (!cached)
+		return false;
+
+	*image = cached->image;
+	if (size)
+		*size = cached->itemSize;
+	return true;
+}
+
+/**
+ * \brief Rasterize the requested image and add it to the cache.
+ * Errors result in a placeholder image that isn't cached.
+ * \param request The request.
+ * \param size Receives the size of the image or element in the SVG. May be null.
+ * \return The image.
+ */
+QImage SvgRasterizer::rasterize(const Request& request, QSize* size)
+{
+	const QSize& requestedSize = request.requestedSize;
+
+	if (!request.error.isEmpty())
+		return placeholder(request.error, requestedSize);
 
 	// Load image
-	QSvgRenderer renderer;
-	if (!renderer.load(imagepath))
+	std::shared_ptr<QSvgRenderer> renderer = getRenderer(request.path);
+	if (!renderer)
 	{
-		qWarning() << "Unable to load image:" << imagepath;
-		return placeholder(QStringLiteral("Unable to load image:\n") + imagepath, requestedSize);
+		qWarning() << "Unable to load image:" << request.path;
+		return placeholder(QStringLiteral("Unable to load image:\n") + request.path, requestedSize);
 	}
 
 	// Check whether requested element exists
-	if (!elementId.isEmpty() && !renderer.elementExists(elementId))
-		return placeholder(QStringLiteral("Unable to find element:\n") + elementId + "\nin image:\n" + imagepath,
-		                   requestedSize);
+	if (!request.elementId.isEmpty() && !renderer->elementExists(request.elementId))
+		return placeholder(QStringLiteral("Unable to find element:\n") + request.elementId + "\nin image:\n"
+		                   + request.path, requestedSize);
 
 	// Get image or element size
-	QSize itemSize = elementId.isEmpty() ? renderer.defaultSize() : renderer.boundsOnElement(elementId).size().toSize();
+	QSize itemSize = request.elementId.isEmpty() ? renderer->defaultSize()
+	                 : renderer->boundsOnElement(request.elementId).size().toSize();
 
 	if (size)
 		*size = itemSize;
@@ -124,10 +229,138 @@ QImage SvgElementProvider::requestImage(const QString& id, QSize* size, const QS
 
 	// Paint svg or element
 	QPainter p(&image);
-	if (elementId.isEmpty())
-		renderer.render(&p);
+	if (request.elementId.isEmpty())
+		renderer->render(&p);
 	else
-		renderer.render(&p, elementId);
+		renderer->render(&p, request.elementId);
+	p.end();
+
+	QMutexLocker lock(&mMutex);
+	mImages.insert(request.key, CachedImage { request.path % '#' % request.elementId, image, itemSize },
+	               image.byteCount());
+
+	return image;
+}
+
+/**
+ * \brief Set the maximum number of bytes used by rasterized images.
+ * \param bytes The budget.
+ */
+void SvgRasterizer::setImageCacheBudget(std::size_t bytes)
+{
+	QMutexLocker lock(&mMutex);
+	mImages.setBudget(bytes);
+}
+
+std::size_t SvgRasterizer::getImageCacheCost() const
+{
+	QMutexLocker lock(&mMutex);
+	return mImages.cost();
+}
+
+std::size_t SvgRasterizer::getHits() const
+{
+	QMutexLocker lock(&mMutex);
+	return mImages.hits();
+}
+
+std::size_t SvgRasterizer::getMisses() const
+{
+	QMutexLocker lock(&mMutex);
+	return mImages.misses();
+}
+
+/**
+ * \brief Drop all rasterized images.
+ * Parsed files are kept until their thread ends.
+ */
+void SvgRasterizer::clearCache()
+{
+	QMutexLocker lock(&mMutex);
+	mImages.clear();
+}
+
+/**
+ * \brief Get the memory used by the rasterized images of each layer.
+ * \return File name and element -> Bytes of all cached sizes.
+ */
+std::map<QString, std::size_t> SvgRasterizer::getLayerCosts() const
+{
+	std::map<QString, std::size_t> costs;
+
+	QMutexLocker lock(&mMutex);
+	mImages.forEach([&costs](const QString&, const CachedImage& cached, std::size_t cost)
+	{
+		costs[cached.layer] += cost;
+	});
+	return costs;
+}
+
+/**
+ * \brief Format the memory usage of the image cache as a table.
+ * \return The table.
+ */
+QString SvgRasterizer::report() const
+{
+	QString out;
+	QTextStream s(&out);
+
+	s << "SVG image cache:\n";
+	s << QString("%1 %2  %3\n").arg("KiB", 10).arg("size", 11).arg("layer");
+
+	QMutexLocker lock(&mMutex);
+	mImages.forEach([&s](const QString&, const CachedImage& cached, std::size_t cost)
+	{
+		s << QString("%1 %2  %3\n").arg(cost / 1024.0, 10, 'f', 1)
+		  .arg(QString("%1x%2").arg(cached.image.width()).arg(cached.image.height()), 11)
+		  .arg(cached.layer);
+	});
+	s << QString("%1 %2  %3\n").arg(mImages.cost() / 1024.0, 10, 'f', 1).arg(QString(), 11)
+	  .arg(QString("<total> atlas hits: %1 hits: %2 misses: %3 evictions: %4").arg(mAtlasHits.load())
+	       .arg(mImages.hits()).arg(mImages.misses()).arg(mImages.evictions()));
+
+	s.flush();
+	return out;
+}
+
+/* Get the parsed file of the current thread */
+std::shared_ptr<QSvgRenderer> SvgRasterizer::getRenderer(const QString& path)
+{
+	std::map<QString, std::shared_ptr<QSvgRenderer>>& renderers = mRenderers.localData();
+
+	auto it = renderers.find(path);
+	if (it != renderers.end())
+		return it->second;
+
+	std::shared_ptr<QSvgRenderer> renderer = std::make_shared<QSvgRenderer>();
+	if (!renderer->load(path))
+		return std::shared_ptr<QSvgRenderer>();
+
+	renderers[path] = renderer;
+	return renderer;
+}
+
+/**
+ * \brief Constructor
+ * \param type QQmlImageProviderBase::Image (default) or QQmlImageProviderBase::Pixmap
+ * \param base The base URL (should end with an "/"). Defaults to "qrc:///"
+ */
+SvgElementProvider::SvgElementProvider(QQmlImageProviderBase::ImageType type, const QUrl& base):
+	QQuickImageProvider(type), mRasterizer(base)
+{
+}
+
+SvgElementProvider::~SvgElementProvider()
+{
+}
+
+QImage SvgElementProvider::requestImage(const QString& id, QSize* size, const QSize& requestedSize)
+{
+	SvgRasterizer::Request request = mRasterizer.resolve(id, requestedSize);
+
+	QImage image;
+	if (!mRasterizer.lookup(request, &image, size))
+		image = mRasterizer.rasterize(request, size);
 
 	return image;
 }
@@ -138,4 +371,3 @@ QPixmap SvgElementProvider::requestPixmap(const QString& id, QSize* size, const
 }
 
 } /* namespace qtouch */
-
@@ -24,27 +24,118 @@
  * \author Moritz Nisblé moritz.nisble@gmx.de
  */
 
+
 #ifndef SVGELEMENTPROVIDER_HPP
 #define SVGELEMENTPROVIDER_HPP
 
+#include <atomic>
+#include <map>
+#include <memory>
+
 #include <QQuickImageProvider>
+#include <QMutex>
+#include <QThreadStorage>
+
+#include "utils/lrucache.hpp"
+
+class QSvgRenderer;
 
 namespace qtouch
 {
 
+/**
+ * \brief Thread safe rasterizer of SVG elements used by the image providers.
+ * Parsed files are kept per thread, because QSvgRenderer isn't thread safe.
+ * Rasterized images are shared by all threads in a cache with a byte budget
+ * that evicts the least recently used ones.\n
+ * Requested sizes are snapped to a few buckets, so items that are resized by
+ * a few pixels still hit the cache. Elements found in the SvgAtlas aren't rendered at all.
+ */
+class SvgRasterizer
+{
+public:
+	/** A resolved image request */
+	struct Request
+	{
+		QString path;
+		QString elementId;
+		/** The requested size snapped to a size bucket */
+		QSize requestedSize;
+		/** Identifies the resulting image */
+		QString key;
+		/** Not empty if the request is invalid */
+		QString error;
+	};
+
+	/** Name of the environment variable that enables the memory report on destruction, see diagnostics::report(). */
+	static const char* ENV_VAR;
+
+	explicit SvgRasterizer(const QUrl& base);
+	~SvgRasterizer();
+
+	static QSize snapSize(const QSize& size);
+
+	/**
+	 * \brief Set the base URL for all images.
+	 * Not thread safe. Set it before any image is requested.
+	 * \param base The base URL (should end with an "/")
+	 */
+	inline void setBaseUrl(const QUrl& base) { mBaseUrl = base; }
+
+	Request resolve(const QString& id, const QSize& requestedSize) const;
+	bool lookup(const Request& request, QImage* image, QSize* size);
+	QImage rasterize(const Request& request, QSize* size);
+
+	void setImageCacheBudget(std::size_t bytes);
+	std::size_t getImageCacheCost() const;
+	std::size_t getHits() const;
+	std::size_t getMisses() const;
+	/** Images served from the SvgAtlas */
+	inline std::size_t getAtlasHits() const { return mAtlasHits; }
+	void clearCache();
+
+	std::map<QString, std::size_t> getLayerCosts() const;
+	QString report() const;
+
+private:
+	struct CachedImage
+	{
+		/* File name and element */
+		QString layer;
+		QImage image;
+		/* Size of the image or element in the SVG */
+		QSize itemSize;
+	};
+
+	std::shared_ptr<QSvgRenderer> getRenderer(const QString& path);
+
+	QUrl mBaseUrl;
+
+	/* File name -> Parsed SVG of the current thread */
+	QThreadStorage<std::map<QString, std::shared_ptr<QSvgRenderer>>> mRenderers;
+
+	/* Guards the image cache */
+	mutable QMutex mMutex;
+	/* File name, element and requested size -> Rasterized image */
+	LruCache<QString, CachedImage> mImages;
+
+	std::atomic<std::size_t> mAtlasHits;
+};
+
 /**
  * \brief QQuickImageProvider that is able to extract elements from Scalable Vector Graphics (SVG).
  * After adding an instance of this class to the QML engine, is is possible to load SVG elements into
  * Images. See Qt reference for an usage example.\n
  * The element is specified by a URL fragment identifier (#elementId). If the given URL lacks a fragment identifier,
- * the whole image is loaded.
+ * the whole image is loaded.\n
+ * Images are rendered synchronously. See AsyncSvgElementProvider for rendering on a thread pool.
  */
 class SvgElementProvider : public QQuickImageProvider
 {
 public:
 	explicit SvgElementProvider(QQmlImageProviderBase::ImageType type = QQmlImageProviderBase::Image,
 	                            const QUrl& base = QUrl(QStringLiteral("qrc:///")));
-	virtual ~SvgElementProvider() {}
+	virtual ~SvgElementProvider();
 
 	virtual QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize);
 	virtual QPixmap requestPixmap(const QString& id, QSize* size, const QSize& requestedSize);
@@ -53,10 +144,12 @@ public:
 	 * \brief Set the base URL for all images loaded by this provider.
 	 * \param base The base URL (should end with an "/")
 	 */
-	inline void setBaseUrl(const QUrl& base) { mBaseUrl = base; }
+	inline void setBaseUrl(const QUrl& base) { mRasterizer.setBaseUrl(base); }
+
+	inline SvgRasterizer& getRasterizer() { return mRasterizer; }
 
 private:
-	QUrl mBaseUrl;
+	SvgRasterizer mRasterizer;
 };
 
 } /* namespace qtouch */
@@ -0,0 +1,328 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file textlayer.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "gui/textlayer.hpp"
+
+#include <algorithm>
+
+#include <QtMath>
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+#include <QSGSimpleRectNode>
+#include <QAbstractTextDocumentLayout>
+
+#include "document.hpp"
+#include "typingstate.hpp"
+
+namespace qtouch
+{
+
+TextLayer::TextLayer(Document* doc, QQuickItem* parent) :
+	QQuickItem(parent), mDoc(doc)
+{
+	setFlag(ItemHasContents, true);
+}
+
+TextLayer::~TextLayer()
+{
+}
+
+/**
+ * Set the state used to draw the typed text.
+ * @param state The state or nullptr to draw the document as it is.
+ * @param textStart The document position of the first character of the state.
+ */
+void TextLayer::setTypingState(const TypingState* state, int textStart)
+{
+	mState = state;
+	mTextStart = textStart;
+	mRebuild = true;
+	update();
+}
+
+void TextLayer::setTypedFormat(const QTextCharFormat& format)
+{
+	mTypedFormat = format;
+}
+
+void TextLayer::setMissFormat(const QTextCharFormat& format)
+{
+	mMissFormat = format;
+}
+
+/**
+ * Rasterize the lines again on the next frame.
+ * Must be called when the layout of the document changed.
+ * @param scale The scale from document to item coordinates.
+ */
+void TextLayer::relayout(qreal scale)
+{
+	mScale = scale;
+	polish();
+}
+
+/**
+ * Update the state of the given characters on the next frame.
+ * @param from Index of the first changed character of the TypingState.
+ * @param to Index behind the last changed character.
+ */
+void TextLayer::markChanged(int from, int to)
+{
+	if (from >= to)
+		return;
+
+	mDirtyFrom = (mDirtyFrom < 0) ? from : qMin(mDirtyFrom, from);
+	mDirtyTo = qMax(mDirtyTo, to);
+	update();
+}
+
+void TextLayer::updatePolish()
+{
+	mLines.clear();
+
+	QVector<QTextLayout::FormatRange> typedFormats(1);
+	typedFormats[0].format = mTypedFormat;
+
+	for (QTextBlock block = mDoc->begin(); block.isValid(); block = block.next())
+	{
+		QTextLayout* layout = block.layout();
+		if (!layout)
+			continue;
+
+		typedFormats[0].start = 0;
+		typedFormats[0].length = block.length();
+
+		for (int i = 0; i < layout->lineCount(); ++i)
+		{
+			QTextLine tl = layout->lineAt(i);
+
+			Line line;
+			line.block = block;
+			line.lineNumber = i;
+			line.start = block.position() + tl.textStart();
+			line.length = tl.textLength();
+			line.rect = tl.rect().translated(layout->position());
+			line.untyped = rasterize(line, QVector<QTextLayout::FormatRange>());
+			// The title is never typed
+			if (mState && line.start >= mTextStart)
+				line.typed = rasterize(line, typedFormats);
+			line.untypedNode = nullptr;
+			line.typedNode = nullptr;
+
+			mLines.push_back(line);
+		}
+	}
+
+	mRebuild = true;
+	update();
+}
+
+QSGNode* TextLayer::updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*)
+{
+	QSGNode* root = oldNode;
+	if (!root)
+	{
+		root = new QSGNode();
+		mRebuild = true;
+	}
+
+	if (mRebuild)
+	{
+		// Children are owned by their parent
+		while (QSGNode* child = root->firstChild())
+		{
+			root->removeChildNode(child);
+			delete child;
+		}
+		mMisses.clear();
+
+		for (Line& line : mLines)
+		{
+			line.untypedNode = createNode(line.untyped);
+			if (line.untypedNode)
+				root->appendChildNode(line.untypedNode);
+			line.typedNode = createNode(line.typed);
+			if (line.typedNode)
+				root->appendChildNode(line.typedNode);
+			updateSplit(line);
+		}
+
+		mMissRoot = new QSGNode();
+		root->appendChildNode(mMissRoot);
+		if (mState && !mLines.empty())
+		{
+			for (int i = 0; i < mState->position(); ++i)
+				updateMiss(i);
+		}
+
+		mRebuild = false;
+	}
+	else if (mDirtyFrom >= 0 && mState && !mLines.empty())
+	{
+		int first = findLine(mTextStart + mDirtyFrom);
+		int last = findLine(mTextStart + mDirtyTo);
+		for (int l = first; l <= last; ++l)
+			updateSplit(mLines[l]);
+
+		for (int i = mDirtyFrom; i < mDirtyTo && i < mState->size(); ++i)
+			updateMiss(i);
+	}
+
+	mDirtyFrom = -1;
+	mDirtyTo = -1;
+
+	return root;
+}
+
+QImage TextLayer::rasterize(const Line& line, const QVector<QTextLayout::FormatRange>& formats) const
+{
+	const qreal scale = mScale * (window() ? window()->effectiveDevicePixelRatio() : 1);
+	QSize size(qCeil(line.rect.width() * scale), qCeil(line.rect.height() * scale));
+	if (size.isEmpty())
+		return QImage();
+
+	QImage image(size, QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::transparent);
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::TextAntialiasing);
+	painter.setPen(Qt::black);
+	painter.scale(scale, scale);
+	painter.translate(-line.rect.topLeft());
+	line.block.layout()->draw(&painter, QPointF(), formats, line.rect);
+
+	return image;
+}
+
+QSGSimpleTextureNode* TextLayer::createNode(const QImage& image) const
+{
+	if (image.isNull())
+		return nullptr;
+
+	QSGSimpleTextureNode* node = new QSGSimpleTextureNode();
+	node->setTexture(window()->createTextureFromImage(image));
+	node->setOwnsTexture(true);
+	return node;
+}
+
+/* The line that contains the given document position */
+int TextLayer::findLine(int position) const
+{
+	auto it = std::upper_bound(mLines.cbegin(), mLines.cend(), position, [](int pos, const Line& line)
+	{
+		return pos < line.start;
+	});
+	return (it == mLines.cbegin()) ? 0 : static_cast<int>(it - mLines.cbegin()) - 1;
+}
+
+/* X offset of the given document position relative to the line rect */
+qreal TextLayer::cursorToX(const Line& line, int position) const
+{
+	QTextLine tl = line.block.layout()->lineAt(line.lineNumber);
+	return tl.cursorToX(position - line.block.position()) - tl.x();
+}
+
+void TextLayer::updateSplit(Line& line)
+{
+	qreal x = 0;
+	if (mState && line.typedNode)
+	{
+		int position = mTextStart + mState->position();
+		if (position >= line.start + line.length)
+			x = line.rect.width();
+		else if (position > line.start)
+			x = cursorToX(line, position);
+	}
+
+	const QRectF& r = line.rect;
+	if (line.untypedNode)
+	{
+		QSizeF size = line.untypedNode->texture()->textureSize();
+		qreal sx = size.width() / r.width();
+		line.untypedNode->setRect(QRectF((r.left() + x) * mScale, r.top() * mScale, (r.width() - x) * mScale, r.height() * mScale));
+		line.untypedNode->setSourceRect(QRectF(x * sx, 0, size.width() - x * sx, size.height()));
+	}
+	if (line.typedNode)
+	{
+		QSizeF size = line.typedNode->texture()->textureSize();
+		qreal sx = size.width() / r.width();
+		line.typedNode->setRect(QRectF(r.left() * mScale, r.top() * mScale, x * mScale, r.height() * mScale));
+		line.typedNode->setSourceRect(QRectF(0, 0, x * sx, size.height()));
+	}
+}
+
+/* Add or remove the underline of the character at the given index of the TypingState */
+void TextLayer::updateMiss(int index)
+{
+	bool miss = index < mState->position() && mState->at(index).state == TypingState::Miss;
+	auto it = mMisses.find(index);
+
+	if (!miss)
+	{
+		if (it != mMisses.end())
+		{
+			mMissRoot->removeChildNode(it->second);
+			delete it->second;
+			mMisses.erase(it);
+		}
+		return;
+	}
+
+	// Placed once the text is laid out
+	if (mLines.empty())
+		return;
+
+	int position = mTextStart + index;
+	const Line& line = mLines[findLine(position)];
+	QTextLine tl = line.block.layout()->lineAt(line.lineNumber);
+	QFontMetricsF fm(mMissFormat.font());
+
+	// A missed line break has no width of its own
+	qreal x1 = cursorToX(line, position);
+	qreal x2 = (position < line.start + line.length) ? cursorToX(line, position + 1) : x1;
+	QRectF r(line.rect.left() + x1, line.rect.top() + tl.ascent() + fm.underlinePos(),
+	         qMax(x2 - x1, fm.averageCharWidth()), qMax<qreal>(1, fm.lineWidth()));
+
+	QSGSimpleRectNode* node;
+	if (it == mMisses.end())
+	{
+		node = new QSGSimpleRectNode();
+		mMissRoot->appendChildNode(node);
+		mMisses.emplace(index, node);
+	}
+	else
+	{
+		node = it->second;
+	}
+
+	node->setRect(QRectF(r.topLeft() * mScale, r.size() * mScale));
+	node->setColor(mMissFormat.underlineColor());
+}
+
+} /* namespace qtouch */
@@ -0,0 +1,118 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file textlayer.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef TEXTLAYER_HPP_
+#define TEXTLAYER_HPP_
+
+#include <unordered_map>
+#include <vector>
+
+#include <QQuickItem>
+#include <QImage>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QTextCharFormat>
+
+class QSGSimpleTextureNode;
+class QSGSimpleRectNode;
+
+namespace qtouch
+{
+
+class Document;
+class TypingState;
+
+/**
+ * Scene graph renderer for a Document.
+ * Each text line is rasterized once per layout into an untyped and a typed
+ * texture. The typed part of a line is shown by splitting the line between
+ * the two textures and misses are marked with underline rectangles. So a
+ * keystroke only changes the geometry of the nodes around the changed
+ * characters. Only simple texture and rectangle nodes are used, which are
+ * supported by the software backend.
+ */
+class TextLayer: public QQuickItem
+{
+public:
+	TextLayer(Document* doc, QQuickItem* parent);
+	virtual ~TextLayer();
+
+	void setTypingState(const TypingState* state, int textStart);
+	void setTypedFormat(const QTextCharFormat& format);
+	void setMissFormat(const QTextCharFormat& format);
+
+	void relayout(qreal scale);
+	void markChanged(int from, int to);
+
+protected:
+	virtual void updatePolish() Q_DECL_OVERRIDE;
+	virtual QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) Q_DECL_OVERRIDE;
+
+private:
+	struct Line
+	{
+		QTextBlock block;
+		int lineNumber;
+		/* Document position and length of the text */
+		int start;
+		int length;
+		/* Document coordinates */
+		QRectF rect;
+		/* Kept to be able to recreate the nodes */
+		QImage untyped;
+		QImage typed;
+		QSGSimpleTextureNode* untypedNode;
+		QSGSimpleTextureNode* typedNode;
+	};
+
+	QImage rasterize(const Line& line, const QVector<QTextLayout::FormatRange>& formats) const;
+	QSGSimpleTextureNode* createNode(const QImage& image) const;
+	int findLine(int position) const;
+	qreal cursorToX(const Line& line, int position) const;
+	void updateSplit(Line& line);
+	void updateMiss(int index);
+
+	Document* mDoc;
+	const TypingState* mState = nullptr;
+	int mTextStart = 0;
+	QTextCharFormat mTypedFormat;
+	QTextCharFormat mMissFormat;
+
+	qreal mScale = 1;
+	std::vector<Line> mLines;
+	bool mRebuild = true;
+	int mDirtyFrom = -1;
+	int mDirtyTo = -1;
+
+	/* Render thread */
+	QSGNode* mMissRoot = nullptr;
+	std::unordered_map<int, QSGSimpleRectNode*> mMisses;
+};
+
+} /* namespace qtouch */
+
+#endif /* TEXTLAYER_HPP_ */
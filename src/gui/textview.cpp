@@ -29,12 +29,16 @@
 #include <QtMath>
 #include <QPainter>
 #include <QPen>
+#include <QQuickWindow>
+#include <QTextBlock>
+
+#include "gui/textlayer.hpp"
 
 namespace qtouch
 {
 
 TextView::TextView(QQuickItem* parent):
-	QQuickPaintedItem(parent), mDoc(new Document(this)), mBorder(new Border(this))
+	QQuickPaintedItem(parent), mDoc(new Document(this)), mTextLayer(new TextLayer(mDoc, this)), mBorder(new Border(this))
 {
 	setFlag(ItemHasContents, true);
 	setRenderTarget(QQuickPaintedItem::FramebufferObject);
@@ -70,6 +74,67 @@ void TextView::setMinWidth(qreal minWidth)
 	}
 }
 
+void TextView::setRenderMode(RenderMode mode)
+{
+	if (mode != mRenderMode)
+	{
+		mRenderMode = mode;
+		mTextLayer->setVisible(mRenderMode == SceneGraph);
+		invalidateCache();
+		mCache = QImage();
+		resize();
+		update();
+		emit renderModeChanged();
+	}
+}
+
+/**
+ * Redraw the text after the given characters changed their format.
+ * @param from Index of the first changed character in the lesson text.
+ * @param to Index behind the last changed character.
+ */
+void TextView::updateText(int from, int to)
+{
+	if (mRenderMode == SceneGraph)
+	{
+		mTextLayer->markChanged(from, to);
+		return;
+	}
+
+	// The lines of both ends and everything in between
+	int textStart = mDoc->getFirstTextBlock().position();
+	QRectF dirty = lineRect(textStart + from) | lineRect(textStart + to);
+	if (dirty.isEmpty())
+		return;
+
+	mCacheDirty |= dirty;
+
+	const qreal scale = contentsScale();
+	update(QRectF(dirty.topLeft() * scale, dirty.size() * scale).toAlignedRect());
+}
+
+/* The rect of the text line that contains the given document position in document coordinates */
+QRectF TextView::lineRect(int position) const
+{
+	QTextBlock block = mDoc->findBlock(position);
+	if (!block.isValid() || !block.layout())
+		return QRectF();
+
+	QTextLayout* layout = block.layout();
+	QTextLine line = layout->lineForTextPosition(position - block.position());
+	if (!line.isValid())
+		return QRectF();
+
+	return line.rect().translated(layout->position());
+}
+
+/* Draw the whole document on the next paint */
+void TextView::invalidateCache()
+{
+	mCacheValid = false;
+	mCacheDirty = QRectF();
+}
+
 void TextView::resize()
 {
 	// IdealWith is defined by the longest line plus margins
@@ -85,7 +150,9 @@ void TextView::resize()
 	setContentsScale(scale);
 
 	// Note: Its crucial to define the TextWidth before accessing the size().height()
-	mDoc->setTextWidth(idealWidth);
+	// Setting the width always relayouts, even if it is unchanged
+	if (mDoc->textWidth() != idealWidth)
+		mDoc->setTextWidth(idealWidth);
 
 	// height is defined by document
 	qreal itemHeight = mDoc->size().height();
@@ -97,6 +164,16 @@ void TextView::resize()
 
 		setContentsSize(QSize(idealWidth, itemHeight));
 
+		if (mRenderMode == SceneGraph)
+		{
+			mTextLayer->setSize(QSizeF(width(), height()));
+			mTextLayer->relayout(scale);
+		}
+		else
+		{
+			invalidateCache();
+		}
+
 		update();
 	}
 }
@@ -121,7 +198,52 @@ void TextView::paint(QPainter* painter)
 		painter->drawRect(contentsBoundingRect());
 		painter->restore();
 	}
-	mDoc->drawContents(painter);
+
+	if (mRenderMode == SceneGraph)
+		return;
+
+	// Draw the changed lines into the cache
+	const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1;
+	const qreal scale = contentsScale() * dpr;
+	const QRectF all(QPointF(0, 0), contentsSize());
+	const QSize size = QSizeF(all.size() * scale).toSize();
+	if (size.isEmpty())
+		return;
+
+	if (mCache.size() != size)
+	{
+		mCache = QImage(size, QImage::Format_ARGB32_Premultiplied);
+		mCacheValid = false;
+	}
+
+	QRectF area = mCacheValid ? (mCacheDirty & all) : all;
+	if (!area.isEmpty())
+	{
+		QPainter cachePainter(&mCache);
+		cachePainter.setRenderHints(painter->renderHints());
+		cachePainter.scale(scale, scale);
+		cachePainter.setClipRect(area);
+		cachePainter.setCompositionMode(QPainter::CompositionMode_Source);
+		cachePainter.fillRect(area, Qt::transparent);
+		cachePainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+		QAbstractTextDocumentLayout::PaintContext context;
+		context.palette.setColor(QPalette::Text, Qt::black);
+		context.clip = area;
+		context.selections = getSelections();
+		mDoc->documentLayout()->draw(&cachePainter, context);
+	}
+	mCacheValid = true;
+	mCacheDirty = QRectF();
+
+	// Untouched lines are copied from the cache
+	QRectF dirty = painter->hasClipping() ? (painter->clipBoundingRect() & all) : all;
+	painter->drawImage(dirty, mCache, QRectF(dirty.topLeft() * scale, dirty.size() * scale));
+}
+
+QVector<QAbstractTextDocumentLayout::Selection> TextView::getSelections() const
+{
+	return QVector<QAbstractTextDocumentLayout::Selection>();
 }
 
 } /* namespace qtouch */
@@ -30,12 +30,16 @@
 #include <memory>
 #include <QQuickPaintedItem>
 #include <QColor>
+#include <QImage>
+#include <QAbstractTextDocumentLayout>
 
 #include "document.hpp"
 
 namespace qtouch
 {
 
+class TextLayer;
+
 class Border: public QObject
 {
 	Q_OBJECT
@@ -63,7 +67,9 @@ private:
  * When the ideal width for the given font size is bigger than maxWidth, the text is
  * scaled down. When it's smaller than minWidth it's scaled up.\n
  * The height of the whole document depends on the count of lines and the calculated
- * scale (use a Flickable/ScrollView).
+ * scale (use a Flickable/ScrollView).\n
+ * The text is drawn by a TextLayer in the scene graph by default. The painted
+ * render mode draws the whole document into the item instead.
  */
 class TextView: public QQuickPaintedItem
 {
@@ -73,8 +79,15 @@ class TextView: public QQuickPaintedItem
 	Q_PROPERTY(qreal maxWidth READ getMaxWidth WRITE setMaxWidth NOTIFY maxWidthChanged)
 	Q_PROPERTY(qreal minWidth READ getMinWidth WRITE setMinWidth NOTIFY minWidthChanged)
 	Q_PROPERTY(qtouch::Border* border READ getBorder CONSTANT)
+	Q_PROPERTY(RenderMode renderMode READ getRenderMode WRITE setRenderMode NOTIFY renderModeChanged)
+	Q_ENUMS(RenderMode)
 
 public:
+	enum RenderMode
+	{
+		Painted, SceneGraph
+	};
+
 	TextView(QQuickItem* parent = nullptr);
 	virtual ~TextView();
 
@@ -88,16 +101,33 @@ public:
 
 	inline Border* getBorder() const { return mBorder; }
 
+	inline RenderMode getRenderMode() const { return mRenderMode; }
+	void setRenderMode(RenderMode mode);
+
 signals:
 	void maxWidthChanged();
 	void minWidthChanged();
+	void renderModeChanged();
 
 protected:
 	virtual void resize();
 
 	virtual void paint(QPainter* painter) Q_DECL_OVERRIDE;
+	/** Formats drawn over the document without modifying it. */
+	virtual QVector<QAbstractTextDocumentLayout::Selection> getSelections() const;
+	void updateText(int from, int to);
+	QRectF lineRect(int position) const;
+	void invalidateCache();
 
 	Document* mDoc;
+	TextLayer* mTextLayer;
+	RenderMode mRenderMode = SceneGraph;
+
+	/* Painted mode: The document at device resolution. Only the dirty lines are drawn again. */
+	QImage mCache;
+	bool mCacheValid = false;
+	/* Document coordinates */
+	QRectF mCacheDirty;
 
 	qreal mMaxWidth = 0;
 	qreal mMinWidth = 0;
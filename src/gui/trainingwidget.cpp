@@ -30,35 +30,87 @@
 #include <QTextBlock>
 #include <QPointF>
 #include <QRectF>
-#include <QPainter>
 #include <QAbstractTextDocumentLayout>
 #include <QTimer>
+#include <QSGSimpleRectNode>
 
+#include "gui/textlayer.hpp"
+#include "gui/latencymonitor.hpp"
 #include "recorder.hpp"
 
 namespace qtouch
 {
 
-TrainingWidget::TrainingWidget(QQuickItem* parent) :
-	TextView(parent), mRecorder(nullptr), mBlinkTimer(new QTimer(this))
+namespace
 {
-	mCursor = mDoc->getTextCursor();
 
-	mBlinkTimer->setInterval(500);
-	// TODO: Make me configurable!
-	mBlinkTimer->setSingleShot(false);
-	mBlinkTimer->start();
-	connect(mBlinkTimer, &QTimer::timeout, [&]
+// TODO: Make me configurable!
+const int BLINK_INTERVAL = 500;
+/* The cursor stops blinking after 10 s without input */
+const int MAX_BLINKS = 20;
+
+} /* namespace */
+
+/** Solid rectangle that marks the cursor position. */
+class CursorItem: public QQuickItem
+{
+public:
+	explicit CursorItem(QQuickItem* parent) : QQuickItem(parent)
 	{
-		mCursorVisible = !mCursorVisible;
+		setFlag(ItemHasContents, true);
+	}
+
+	void setColor(const QColor& color)
+	{
+		if (color != mColor)
+		{
+			mColor = color;
+			update();
+		}
+	}
+
+protected:
+	virtual QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) Q_DECL_OVERRIDE
+	{
+		QSGSimpleRectNode* node = static_cast<QSGSimpleRectNode*>(oldNode);
+		if (!node)
+			node = new QSGSimpleRectNode();
+		node->setRect(boundingRect());
+		node->setColor(mColor);
+		return node;
+	}
+
+	virtual void geometryChanged(const QRectF& newGeometry, const QRectF& oldGeometry) Q_DECL_OVERRIDE
+	{
+		QQuickItem::geometryChanged(newGeometry, oldGeometry);
 		update();
-	});
+	}
+
+private:
+	QColor mColor;
+};
+
+TrainingWidget::TrainingWidget(QQuickItem* parent) :
+	TextView(parent), mRecorder(nullptr), mLatency(new LatencyMonitor(this)), mCursorItem(new CursorItem(this)), mBlinkTimer(new QTimer(this))
+{
+	mTextStart = mDoc->getFirstTextBlock().position();
+
+	// Only blinks after input and stops when idle
+	mBlinkTimer->setInterval(BLINK_INTERVAL);
+	mBlinkTimer->setSingleShot(false);
+	connect(mBlinkTimer, &QTimer::timeout, this, &TrainingWidget::blink);
+
+	connect(this, &QQuickItem::windowChanged, mLatency, &LatencyMonitor::setWindow);
+
+	// The cursor item lives in item coordinates
+	connect(this, &QQuickPaintedItem::contentsScaleChanged, this, &TrainingWidget::updateCursorItem);
 
 	configureTextFormat();
+	mTextLayer->setTypedFormat(mCorrectTextCharFormat);
+	mTextLayer->setMissFormat(mFailureTextCharFormat);
 
 	// TODO: React on text format changes in Document
-	connect(mDoc, &Document::titleChanged, this, &TrainingWidget::resetCursor);
-	connect(mDoc, &Document::textChanged, this, &TrainingWidget::resetCursor);
+	connect(mDoc, &Document::contentChanged, this, &TrainingWidget::resetState);
 }
 
 TrainingWidget::~TrainingWidget()
@@ -92,21 +144,31 @@ void TrainingWidget::setRecoder(Recorder* recorder)
 	}
 }
 
+void TrainingWidget::setCorrectionLimit(int limit)
+{
+	if (limit != mState.getCorrectionLimit())
+	{
+		mState.setCorrectionLimit(limit);
+		emit correctionLimitChanged();
+	}
+}
+
 int TrainingWidget::getActiveLineNumber() const
 {
-	return mCursor->blockNumber() - 1;
+	return getCursorGeometry(mState.position()).blockNumber - 1;
 }
 
 int TrainingWidget::getCursorPosition() const
 {
-	return mCursor->positionInBlock();
+	return getCursorGeometry(mState.position()).positionInBlock;
 }
 
 void TrainingWidget::reset()
 {
-	mDoc->resetText();
-	mDoc->clearUndoRedoStacks();
+	mState.restart();
 	resetCursor();
+	updateProgress(0);
+	updateText(0, mState.size());
 	if (mRecorder)
 		mRecorder->reset();
 }
@@ -137,32 +199,77 @@ void TrainingWidget::configureTextFormat()
 	mDoc->setTextCharFormat(standardFormat);
 }
 
+void TrainingWidget::resetState()
+{
+	mState.reset(mDoc->getText());
+	resetCursor();
+	updateProgress(0);
+}
+
 void TrainingWidget::resetCursor()
 {
-	mCursor = mDoc->getTextCursor();
+	mTextStart = mDoc->getFirstTextBlock().position();
+	mGeometry.invalidate();
+	mTextLayer->setTypingState(&mState, mTextStart);
 	emit activeLineNumberChanged();
 	emit cursorPositionChanged();
 	updateCursorRect();
+	restartBlinking();
+}
+
+/**
+ * The cursor geometry at the given index of the lesson text.
+ * @param index The index.
+ * @return The geometry.
+ */
+CursorGeometry::Position TrainingWidget::getCursorGeometry(int index) const
+{
+	if (!mGeometry.isValid())
+		mGeometry.build(mDoc, mTextStart);
+	return mGeometry.at(index);
 }
 
 void TrainingWidget::updateCursorRect()
 {
-	// Get the top left edge of the current text block
-	QPointF blockTopLeft = mDoc->documentLayout()->blockBoundingRect(mCursor->block()).topLeft();
-	// Get the current text line from the text layout of the current block
-	QTextLine textLine = mCursor->block().layout()->lineForTextPosition(mCursor->positionInBlock());
-	// Calculate the unscaled top left position of the cursor
-	QPointF topLeft(blockTopLeft.x() + textLine.cursorToX(mCursor->positionInBlock()), blockTopLeft.y() + textLine.y());
-	// And the bottom right position
-	QPointF bottomRight(topLeft.x() + 1, topLeft.y() + textLine.height());
-
-	// Use the points to span the cursor rectangle
-	mCursorRectangle.setTopLeft(topLeft);
-	mCursorRectangle.setBottomRight(bottomRight);
+	mCursorRectangle = getCursorGeometry(mState.position()).rect;
+
+	updateCursorItem();
 
 	emit cursorRectangleChanged();
 }
 
+void TrainingWidget::updateCursorItem()
+{
+	const qreal scale = contentsScale();
+	mCursorItem->setPosition(mCursorRectangle.topLeft() * scale);
+	mCursorItem->setSize(mCursorRectangle.size() * scale);
+	mCursorItem->setColor(mCorrectTextCharFormat.foreground().color());
+}
+
+/**
+ * Show the cursor and start blinking.
+ * Called on input so that an idle widget doesn't wake up.
+ */
+void TrainingWidget::restartBlinking()
+{
+	mBlinks = 0;
+	mCursorItem->setVisible(true);
+	mBlinkTimer->start();
+}
+
+void TrainingWidget::blink()
+{
+	if (++mBlinks >= MAX_BLINKS)
+	{
+		mBlinkTimer->stop();
+		mCursorItem->setVisible(true);
+	}
+	else
+	{
+		mCursorItem->setVisible(!mCursorItem->isVisible());
+	}
+}
+
 void TrainingWidget::updateProgress(qreal percent)
 {
 	mProgress = percent;
@@ -174,6 +281,9 @@ void TrainingWidget::keyPressEvent(QKeyEvent* keyEvent)
 	// Qt::WA_KeyCompression should be disabled
 	Q_ASSERT(keyEvent->count() == 1);
 
+	// Only marked when the key changed something, see below
+	const qint64 arrival = mLatency->timestamp();
+
 	// Catch configured escape key
 	if (keyEvent->modifiers() == Qt::NoModifier && keyEvent->key() == mEscKey)
 	{
@@ -183,64 +293,49 @@ void TrainingWidget::keyPressEvent(QKeyEvent* keyEvent)
 	}
 
 	bool cursorMoved = false;
+	const int oldPosition = mState.position();
+
+	restartBlinking();
 
 	//	qDebug() << "Input: (" << QStringLiteral("0x%1").arg(keyEvent->key(), 8, 16, QChar('0')) << ")" << keyEvent->text();
 
 	// Catch backspace
 	if (keyEvent->key() == Qt::Key_Backspace)
 	{
-		if (mDoc->isUndoAvailable())
+		if (mState.canRetreat())
 		{
-			int lineNumber = mCursor->blockNumber();
-
-			// FIXME: This is all crap!!
+			TypingState::Cell cell = mState.retreat();
 
-			mCursor->movePosition(QTextCursor::PreviousCharacter, QTextCursor::KeepAnchor);
-			QString deleted = mCursor->selectedText();
-			mCursor->movePosition(QTextCursor::PreviousCharacter);
-
-			mDoc->undo(mCursor.get());
-			mCursor->movePosition(QTextCursor::PreviousCharacter, QTextCursor::KeepAnchor);
-			QString ref = mCursor->selectedText();
-			mCursor->clearSelection();
-
-			if (mRecorder)
+			// Only take back what was counted
+			if (mRecorder && cell.counted)
 			{
-				if (deleted == ref)
-					mRecorder->unhit();
+				if (cell.state == TypingState::Hit)
+					mRecorder->unhit(cell.expected, cell.typed);
 				else
-					mRecorder->unmiss();
+					mRecorder->unmiss(cell.expected, cell.typed);
 			}
 
-			// If block number changed while undo, inform clients
-			if (mCursor->blockNumber() != lineNumber)
-				emit activeLineNumberChanged();
-
 			cursorMoved = true;
 		}
 	}
 	else if (!keyEvent->text().isEmpty())
 	{
-		// Extract reference text from mText variable
-		int refStart = mCursor->position() - mDoc->getTitle().size() - 1;
-		QString refText = mDoc->getText().mid(refStart, keyEvent->text().size());
-
 		// If no text left, end is reached.
-		if (refText.isEmpty())
+		if (mState.atEnd())
 		{
 			qDebug() << "Finished!";
 			return;
 		}
 
-		mCursor->beginEditBlock();
-		for (int i = 0; i < refText.size(); ++i)
+		for (int i = 0; i < keyEvent->text().size() && !mState.atEnd(); ++i)
 		{
 			// Pay attention with comparison when input method produce multiple chars at once!
 
-			mCursor->clearSelection();
+			const QChar cTyped = keyEvent->text().at(i);
+			const QChar cRef = mState.expected();
 
 			// Line break handling
-			if (mCursor->atBlockEnd())
+			if (cRef == QChar::LineFeed)
 			{
 				// XXX: Make me configurable!
 				bool lineBreakWithSpace = true;
@@ -249,11 +344,10 @@ void TrainingWidget::keyPressEvent(QKeyEvent* keyEvent)
 				if ((lineBreakWithReturn && (keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter))
 				        || (lineBreakWithSpace && keyEvent->key() == Qt::Key_Space))
 				{
-					mCursor->movePosition(QTextCursor::NextBlock);
-					emit activeLineNumberChanged();
+					mState.advance(QChar::LineFeed, mRecorder != nullptr);
 
 					if (mRecorder)
-						mRecorder->hit();
+						mRecorder->hit(QChar::LineFeed, cTyped);
 
 					cursorMoved = true;
 				}
@@ -261,44 +355,29 @@ void TrainingWidget::keyPressEvent(QKeyEvent* keyEvent)
 				{
 					qDebug() << "Action needed";
 					if (mRecorder)
-						mRecorder->miss();
+						mRecorder->miss(QChar::LineFeed, cTyped);
 				}
 			}
+			else if (!cTyped.isPrint()) // Filter unprintable characters
+			{
+				qDebug() << "Unprintable character";
+				if (mRecorder)
+					mRecorder->miss(cRef, cTyped);
+			}
 			else
 			{
-				const QChar cTyped = keyEvent->text().at(i);
-				const QChar cRef = refText.at(i);
-
-				if (!cTyped.isPrint()) // Filter unprintable characters
-				{
-					qDebug() << "Unprintable character";
-					if (mRecorder)
-						mRecorder->miss();
-				}
-				else if (cTyped == cRef)
-				{
-					// Select next char in document
-					mCursor->movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
-					// and set format
-					mCursor->insertText(cRef, mCorrectTextCharFormat);
+				TypingState::State state = mState.advance(cTyped, mRecorder != nullptr);
 
-					cursorMoved = true;
-					if (mRecorder)
-						mRecorder->hit();
-				}
-				else
+				cursorMoved = true;
+				if (mRecorder)
 				{
-					mCursor->movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
-					mCursor->insertText(cTyped, mFailureTextCharFormat);
-
-					cursorMoved = true;
-					if (mRecorder)
-						mRecorder->miss();
+					if (state == TypingState::Hit)
+						mRecorder->hit(cRef, cTyped);
+					else
+						mRecorder->miss(cRef, cTyped);
 				}
 			}
 		} // for-loop
-
-		mCursor->endEditBlock();
 	}
 	else
 	{
@@ -307,20 +386,47 @@ void TrainingWidget::keyPressEvent(QKeyEvent* keyEvent)
 
 	if (cursorMoved)
 	{
+		mLatency->markInput(arrival);
+
+		// Inform clients if the cursor moved to another line
+		if (getCursorGeometry(oldPosition).blockNumber != getCursorGeometry(mState.position()).blockNumber)
+			emit activeLineNumberChanged();
 		emit cursorPositionChanged();
 
 		updateCursorRect();
-		updateProgress((mCursor->position() - mDoc->getTitle().size() - 1) / static_cast<qreal>(mDoc->getText().size()));
-		update();
+		updateProgress(mState.size() ? mState.position() / static_cast<qreal>(mState.size()) : 0);
+		updateText(qMin(oldPosition, mState.position()), qMax(oldPosition, mState.position()));
 	}
 }
 
-void TrainingWidget::paint(QPainter* painter)
+void TrainingWidget::resize()
 {
-	TextView::paint(painter);
+	TextView::resize();
+
+	// The layout changed
+	mGeometry.invalidate();
+	updateCursorRect();
+}
+
+/**
+ * Draw the typed text over the lesson text with one selection per run.
+ */
+QVector<QAbstractTextDocumentLayout::Selection> TrainingWidget::getSelections() const
+{
+	QVector<QAbstractTextDocumentLayout::Selection> selections;
+	selections.reserve(mState.getRuns().size());
+
+	for (const TypingState::Run& run : mState.getRuns())
+	{
+		QAbstractTextDocumentLayout::Selection selection;
+		selection.cursor = QTextCursor(mDoc);
+		selection.cursor.setPosition(mTextStart + run.start);
+		selection.cursor.setPosition(mTextStart + run.start + run.length, QTextCursor::KeepAnchor);
+		selection.format = (run.state == TypingState::Hit) ? mCorrectTextCharFormat : mFailureTextCharFormat;
+		selections.append(selection);
+	}
 
-	if (mCursorVisible)
-		painter->fillRect(mCursorRectangle, mCursor->charFormat().foreground().color());
+	return selections;
 }
 
 } /* namespace qtouch */
@@ -28,22 +28,29 @@
 #define TRAININGWIDGET_HPP_
 
 #include "gui/textview.hpp"
+#include "gui/cursorgeometry.hpp"
+#include "typingstate.hpp"
 
 class QTimer;
-class QTextCursor;
 
 namespace qtouch
 {
 
 class Recorder;
+class CursorItem;
+class LatencyMonitor;
 
 class TrainingWidget: public TextView
 {
 	Q_OBJECT
 
 	Q_PROPERTY(qtouch::Recorder* recoder READ getRecoder WRITE setRecoder NOTIFY recorderChanged)
+	/* Key to frame latency of this widget */
+	Q_PROPERTY(qtouch::LatencyMonitor* latency READ getLatency CONSTANT)
 
 	Q_PROPERTY(Qt::Key escapeKey MEMBER mEscKey NOTIFY escapeKeyChanged)
+	/* How many characters the user may go back behind the furthest typed one. 0 means unlimited. */
+	Q_PROPERTY(int correctionLimit READ getCorrectionLimit WRITE setCorrectionLimit NOTIFY correctionLimitChanged)
 	Q_PROPERTY(qreal progress READ getProgress NOTIFY progressChanged)
 	Q_PROPERTY(QRectF cursorRectangle READ getCursorRectangle NOTIFY cursorRectangleChanged)
 
@@ -59,6 +66,11 @@ public:
 	Recorder* getRecoder() const { return mRecorder; }
 	void setRecoder(Recorder* recorder);
 
+	inline LatencyMonitor* getLatency() const { return mLatency; }
+
+	inline int getCorrectionLimit() const { return mState.getCorrectionLimit(); }
+	void setCorrectionLimit(int limit);
+
 	inline qreal getProgress() const { return mProgress; }
 	inline QRectF getCursorRectangle() const { return mCursorRectangle; }
 	int getActiveLineNumber() const;
@@ -73,6 +85,7 @@ signals:
 	void recorderChanged();
 	void escape();
 	void escapeKeyChanged();
+	void correctionLimitChanged();
 	void progressChanged();
 	void cursorRectangleChanged();
 	void activeLineNumberChanged();
@@ -80,25 +93,39 @@ signals:
 
 protected:
 	virtual void keyPressEvent(QKeyEvent*) Q_DECL_OVERRIDE;
-	virtual void paint(QPainter* painter) Q_DECL_OVERRIDE;
+	virtual void resize() Q_DECL_OVERRIDE;
+	virtual QVector<QAbstractTextDocumentLayout::Selection> getSelections() const Q_DECL_OVERRIDE;
 
 private:
 	void configureTextFormat();
+	void resetState();
 	void resetCursor();
+	CursorGeometry::Position getCursorGeometry(int index) const;
 	void updateCursorRect();
+	void updateCursorItem();
+	void restartBlinking();
+	void blink();
 	void updateProgress(qreal percent);
 
 	Recorder* mRecorder;
+	LatencyMonitor* mLatency;
 
 	Qt::Key mEscKey = Qt::Key_Escape;
-	std::unique_ptr<QTextCursor> mCursor;
+	/* What has been typed. The document only holds the lesson text. */
+	TypingState mState;
+	/* Built on demand after the layout changed */
+	mutable CursorGeometry mGeometry;
+	/* Document position of the first lesson character */
+	int mTextStart = 0;
 
 	QTextCharFormat mCorrectTextCharFormat;
 	QTextCharFormat mFailureTextCharFormat;
 
-	bool mCursorVisible = false;
 	QRectF mCursorRectangle;
+	/* Drawn by the scene graph to keep blinking away from the document texture */
+	CursorItem* mCursorItem;
 	QTimer* mBlinkTimer;
+	int mBlinks = 0;
 
 	qreal mProgress = 0;
 };
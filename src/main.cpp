@@ -31,6 +31,8 @@
 #include <QQuickWindow>
 #include <QDebug>
 
+#include <memory>
+
 #include "utils/exceptions.hpp"
 #include "datamodel.hpp"
 #include "coursemodel.hpp"
@@ -39,9 +41,13 @@
 #include "wrapper/qmlprofile.hpp"
 #include "document.hpp"
 #include "recorder.hpp"
-#include "gui/svgelementprovider.hpp"
+#include "startuptracer.hpp"
+#include "gui/asyncsvgelementprovider.hpp"
 #include "gui/textview.hpp"
 #include "gui/trainingwidget.hpp"
+#include "gui/gauge.hpp"
+#include "gui/stopwatch.hpp"
+#include "gui/latencymonitor.hpp"
 
 namespace
 {
@@ -75,55 +81,121 @@ void registerQmlTypes()
 	qmlRegisterType<qtouch::Border>();
 	qmlRegisterType<qtouch::TextView>("de.nisble.qtouch", 1, 0, "TextView");
 	qmlRegisterType<qtouch::TrainingWidget>("de.nisble.qtouch", 1, 0, "TrainingWidget");
+	qmlRegisterType<qtouch::Gauge>("de.nisble.qtouch", 1, 0, "Gauge");
+	qmlRegisterType<qtouch::StopWatch>("de.nisble.qtouch", 1, 0, "StopWatch");
+	qmlRegisterType<qtouch::LatencyMonitor>();
 }
 
 } /* namespace anonymous */
 
 int main(int argc, char* argv[])
 {
+	using qtouch::StartupTracer;
+
+	// Parsed before the application exists to trace its construction
+	const QString traceFile = StartupTracer::fileFromArguments(argc, argv);
+	StartupTracer& tracer = StartupTracer::instance();
+	tracer.setEnabled(!traceFile.isEmpty());
+	const qint64 startNs = tracer.now();
+
+	// Written when the first frame and the data arrived, whatever comes last
+	auto tracePending = std::make_shared<int>(1);
+	auto traceDone = [tracePending, traceFile]()
+	{
+		if (--*tracePending)
+			return;
+		StartupTracer::instance().write(traceFile);
+	};
+
+	tracer.begin("QGuiApplication");
 	QGuiApplication app(argc, argv);
+	tracer.end();
 
 	// Use QCommandLineParser to parse arguments (see documentation)
 
+	tracer.begin("QQmlEngine");
 	QQmlEngine engine;
+	tracer.end();
 
 	// Register needed types
+	tracer.begin("register QML types");
 	registerQmlTypes();
+	tracer.end();
 
 	// Add image provider
-	engine.addImageProvider(QStringLiteral("svgelement"), new qtouch::SvgElementProvider(QQmlImageProviderBase::Image,
+	engine.addImageProvider(QLatin1String(qtouch::AsyncSvgElementProvider::NAME), new qtouch::AsyncSvgElementProvider(
 	                        QUrl(QStringLiteral("qrc:///images/"))));
 
+	// Loaded on a worker after the first screen is shown
 	qtouch::DataModel dataModel;
-	try
-	{
-		dataModel.init();
-	}
-	catch (qtouch::Exception& e)
+	QObject::connect(&dataModel, &qtouch::DataModel::failed, &app, [startNs, tracePending, traceDone](const QString& message)
 	{
-		qCritical() << e.message();
-		return EXIT_FAILURE;
-	}
+		qCritical() << message;
+
+		// No first frame is waited for: Write what was traced so far
+		StartupTracer& tracer = StartupTracer::instance();
+		if (tracer.isEnabled())
+		{
+			tracer.addSpan("time to failure", startNs, tracer.now());
+			*tracePending = 1;
+			traceDone();
+		}
+
+		QCoreApplication::exit(EXIT_FAILURE);
+	});
 
 	qtouch::CourseModel* courseModel = new qtouch::CourseModel(&dataModel, &app);
 	qtouch::ProfileModel* profileModel = new qtouch::ProfileModel(&dataModel, &app);
 	// Embed view models
 	engine.rootContext()->setContextProperty("$courseModel", courseModel);
 	engine.rootContext()->setContextProperty("$profileModel", profileModel);
+	engine.rootContext()->setContextProperty("$dataModel", &dataModel);
 
 	// Create root component
 	QQmlComponent component(&engine);
 	QQuickWindow::setDefaultAlphaBuffer(true);
+	tracer.begin("compile QML");
 	component.loadUrl(QUrl(QStringLiteral("qrc:/qml/MainWindow.qml")));
+	tracer.end();
 
 	if (componentError(&component))
 		return EXIT_FAILURE;
 
 	if (component.isReady())
 	{
-		component.create();
+		tracer.begin("create QML");
+		QObject* root = component.create();
+		tracer.end();
 		if (componentError(&component))
 			return EXIT_FAILURE;
+
+		// Asynchronous Loaders incubate the screens while the window is idle
+		if (QQuickWindow* window = qobject_cast<QQuickWindow*>(root))
+		{
+			engine.setIncubationController(window->incubationController());
+
+			if (tracer.isEnabled())
+			{
+				++*tracePending;
+
+				// Emitted on the render thread: Record the time there, finish on the GUI thread
+				auto traced = std::make_shared<QMetaObject::Connection>();
+				*traced = QObject::connect(window, &QQuickWindow::frameSwapped, window, [traced, startNs]()
+				{
+					QObject::disconnect(*traced);
+					StartupTracer& tracer = StartupTracer::instance();
+					tracer.addInstant("first frame");
+					tracer.addSpan("time to first frame", startNs, tracer.now());
+				}, Qt::DirectConnection);
+
+				auto queued = std::make_shared<QMetaObject::Connection>();
+				*queued = QObject::connect(window, &QQuickWindow::frameSwapped, &app, [queued, traceDone]()
+				{
+					QObject::disconnect(*queued);
+					traceDone();
+				}, Qt::QueuedConnection);
+			}
+		}
 	}
 	else
 	{
@@ -131,8 +203,18 @@ int main(int argc, char* argv[])
 		return EXIT_FAILURE;
 	}
 
-	// FIXME: Not nice but fixes initialization problem
-	courseModel->selectCourse(0);
+	if (tracer.isEnabled())
+	{
+		QObject::connect(&dataModel, &qtouch::DataModel::ready, &app, [startNs, traceDone]()
+		{
+			StartupTracer& tracer = StartupTracer::instance();
+			tracer.addSpan("time to data", startNs, tracer.now());
+			traceDone();
+		});
+	}
+
+	// The CourseModel selects the first course when it arrives
+	dataModel.initAsync();
 
 	return app.exec();
 }
@@ -38,7 +38,7 @@
 
 #include "utils/exceptions.hpp"
 #include "coursemodel.hpp"
-#include "gui/svgelementprovider.hpp"
+#include "gui/asyncsvgelementprovider.hpp"
 
 namespace qtouch
 {
@@ -112,7 +112,7 @@ bool MainWindow::init()
 	registerQmlTypes();
 
 	// Add image provider
-	mwEngine->addImageProvider(QStringLiteral("svgelement"), new SvgElementProvider(QQmlImageProviderBase::Image,
+	mwEngine->addImageProvider(QLatin1String(AsyncSvgElementProvider::NAME), new AsyncSvgElementProvider(
 	                           QUrl(QStringLiteral("qrc:///images/"))));
 
 	mDataModel = new DataModel(this);
@@ -44,6 +44,15 @@ ProfileModel::ProfileModel(QObject* parent):
 ProfileModel::ProfileModel(DataModel* model, QObject* parent):
 	QAbstractListModel(parent), mDm(model), mSelected(-1)
 {
+	// Profiles are inserted when the DataModel is ready
+	connect(mDm, &DataModel::profilesAboutToBeInserted, this, [this](int first, int last)
+	{
+		beginInsertRows(QModelIndex(), first, last);
+	});
+	connect(mDm, &DataModel::profilesInserted, this, [this]
+	{
+		endInsertRows();
+	});
 }
 
 ProfileModel::~ProfileModel()
@@ -126,24 +135,15 @@ QHash<int, QByteArray> ProfileModel::roleNames() const
 	return roles;
 }
 
+/* The row is inserted through profilesAboutToBeInserted() and profilesInserted() on success only */
 bool ProfileModel::addProfile(const QString& name, qtouch::QmlProfile::SkillLevel skill)
 {
-	bool result = false;
-	beginInsertRows(QModelIndex(), mDm->getProfileCount(), mDm->getProfileCount());
-	if (mDm->insertProfile(Profile(name, static_cast<Profile::SkillLevel>(skill))))
-		result = true;
-	endInsertRows();
-	return result;
+	return mDm->insertProfile(Profile(name, static_cast<Profile::SkillLevel>(skill)));
 }
 
 bool ProfileModel::addProfile(QmlProfile* profile)
 {
-	bool result = false;
-	beginInsertRows(QModelIndex(), mDm->getProfileCount(), mDm->getProfileCount());
-	if (mDm->insertProfile(*static_cast<Profile*>(profile)))
-		result = true;
-	endInsertRows();
-	return result;
+	return mDm->insertProfile(*static_cast<Profile*>(profile));
 }
 
 } /* namespace qtouch */
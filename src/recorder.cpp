@@ -31,21 +31,30 @@
 namespace qtouch
 {
 
+namespace
+{
+
+/* About 13 minutes at 20 keys per second */
+const int DEFAULT_KEYSTROKE_CAPACITY = 16384;
+
+/* Inactivity after which the recording is paused */
+// TODO: Make it configurable
+const qint64 PAUSE_NS = Q_INT64_C(3000) * 1000000;
+
+} /* namespace */
+
 Recorder::Recorder(QObject* parent) :
-	QObject(parent)
+	QObject(parent), mKeystrokes(DEFAULT_KEYSTROKE_CAPACITY)
 {
-	mStatsTimer = new QTimer(this);
-	mPauseTimer = new QTimer(this);
-	mHintTimer = new QTimer(this);
+	mClock.start();
 
-	mStatsTimer->setInterval(500);
-	mStatsTimer->setSingleShot(false);
-	connect(mStatsTimer, &QTimer::timeout, this, &Recorder::timeout);
+	mNotifyTimer = new QTimer(this);
+	mHintTimer = new QTimer(this);
 
-	// TODO: Make it configurable
-	mPauseTimer->setInterval(3000);
-	mPauseTimer->setSingleShot(true);
-	connect(mPauseTimer, &QTimer::timeout, this, &Recorder::pause);
+	// Only runs while typing
+	mNotifyTimer->setInterval(500);
+	mNotifyTimer->setSingleShot(false);
+	connect(mNotifyTimer, &QTimer::timeout, this, &Recorder::tick);
 
 	// TODO: Make it configurable
 	mHintTimer->setInterval(2000);
@@ -59,13 +68,14 @@ Recorder::~Recorder()
 
 void Recorder::reset()
 {
-	mStatsTimer->stop();
+	mNotifyTimer->stop();
 	mHintTimer->stop();
 
 	mStart = QDateTime();
 	emit startChanged();
 
-	mElapsed = 0;
+	mActiveNs = 0;
+	mResumedAt = -1;
 	emit elapsedChanged();
 
 	mHits = 0;
@@ -73,24 +83,81 @@ void Recorder::reset()
 
 	mMisses = 0;
 	emit missesChanged();
+
+	mKeystrokes.clear();
+	mClock.restart();
+}
+
+/**
+ * Change the number of key events that are kept.
+ * The recorded events are discarded.
+ * @param capacity The maximum number of events.
+ */
+void Recorder::setKeystrokeCapacity(int capacity)
+{
+	mKeystrokes.reset(capacity > 0 ? capacity : 0);
+}
+
+/**
+ * The active typing time in ms.
+ * Includes the current period up to now.
+ */
+int Recorder::getElapsed() const
+{
+	qint64 ns = mActiveNs;
+	if (isRunning())
+		ns += mClock.nsecsElapsed() - mResumedAt;
+	return ns / 1000000;
+}
+
+int Recorder::getElapsedResolution() const
+{
+	return mNotifyTimer->interval();
+}
+
+/**
+ * Set the interval of the elapsedChanged notification while typing.
+ * This doesn't affect the precision of elapsed.
+ * @param ms The interval in ms.
+ */
+void Recorder::setElapsedResolution(int ms)
+{
+	if (ms > 0 && ms != mNotifyTimer->interval())
+	{
+		mNotifyTimer->setInterval(ms);
+		emit elapsedResolutionChanged();
+	}
 }
 
 void Recorder::pause()
 {
+	if (!isRunning())
+		return;
+
 	qDebug() << "Pause";
-	mStatsTimer->stop();
+
+	// The period ends with the inactivity timeout like it was detected in time
+	qint64 end = qMin(mClock.nsecsElapsed(), mLastKeyAt + PAUSE_NS);
+	mActiveNs += end - mResumedAt;
+	mResumedAt = -1;
+
+	mNotifyTimer->stop();
 	mHintTimer->stop();
+
+	emit elapsedChanged();
 }
 
-void Recorder::hit()
+void Recorder::hit(QChar expected, QChar typed)
 {
+	record(Keystroke::Hit, expected, typed);
 	resume();
 	++mHits;
 	emit hitsChanged();
 }
 
-void Recorder::unhit()
+void Recorder::unhit(QChar expected, QChar typed)
 {
+	record(Keystroke::Unhit, expected, typed);
 	resume();
 	if (mHits > 0)
 	{
@@ -99,29 +166,33 @@ void Recorder::unhit()
 	}
 }
 
-void Recorder::miss()
+void Recorder::miss(QChar expected, QChar typed)
 {
+	record(Keystroke::Miss, expected, typed);
 	resume();
 	++mMisses;
 	emit missesChanged();
 }
 
 
-void Recorder::unmiss()
+void Recorder::unmiss(QChar expected, QChar typed)
 {
+	record(Keystroke::Unmiss, expected, typed);
 	resume();
 }
 
-void Recorder::timeout()
+void Recorder::tick()
 {
-	mElapsed += mStatsTimer->interval();
-	emit elapsedChanged();
+	// Inactivity is checked here instead of restarting a timer on each key
+	if (mClock.nsecsElapsed() - mLastKeyAt >= PAUSE_NS)
+		pause();
+	else
+		emit elapsedChanged();
 }
 
 void Recorder::resume()
 {
-	if (!mStatsTimer->isActive())
-		mStatsTimer->start();
+	mLastKeyAt = mClock.nsecsElapsed();
 
 	if (!mStart.isValid())
 	{
@@ -129,12 +200,16 @@ void Recorder::resume()
 		mStart = QDateTime::currentDateTime();
 		emit startChanged();
 	}
-	else if (!mPauseTimer->isActive())
+	else if (!isRunning())
 	{
 		qDebug() << "Resume";
 	}
 
-	mPauseTimer->start();
+	if (!isRunning())
+	{
+		mResumedAt = mLastKeyAt;
+		mNotifyTimer->start();
+	}
 }
 
 } /* namespace qtouch */
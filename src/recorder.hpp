@@ -29,18 +29,39 @@
 
 #include <QObject>
 #include <QDateTime>
+#include <QElapsedTimer>
+
+#include "utils/ringbuffer.hpp"
 
 class QTimer;
 
 namespace qtouch
 {
 
+/**
+ * A single recorded key event.
+ */
+struct Keystroke
+{
+	enum Type : quint8 { Hit, Miss, Unhit, Unmiss };
+
+	/** Monotonic time since the last reset of the Recorder in ns */
+	qint64 timestamp;
+	/** The character of the lesson text */
+	QChar expected;
+	/** The character the user typed */
+	QChar typed;
+	Type type;
+};
+
 class Recorder: public QObject
 {
 	Q_OBJECT
 
 	Q_PROPERTY(QDateTime start READ getStart NOTIFY startChanged)
+	/* Active typing time in ms. Derived from timestamps, notified every elapsedResolution ms while typing. */
 	Q_PROPERTY(int elapsed READ getElapsed NOTIFY elapsedChanged)
+	Q_PROPERTY(int elapsedResolution READ getElapsedResolution WRITE setElapsedResolution NOTIFY elapsedResolutionChanged)
 	Q_PROPERTY(int hits READ getHits NOTIFY hitsChanged)
 	Q_PROPERTY(int misses READ getMisses NOTIFY missesChanged)
 
@@ -49,13 +70,21 @@ public:
 	virtual ~Recorder();
 
 	QDateTime getStart() const { return mStart; }
-	int getElapsed() const { return mElapsed; }
+	int getElapsed() const;
+	int getElapsedResolution() const;
+	void setElapsedResolution(int ms);
+	inline bool isRunning() const { return mResumedAt >= 0; }
 	int getHits() const { return mHits; }
 	int getMisses() const { return mMisses; }
 
+	/** The recorded key events from the oldest to the newest. */
+	inline const RingBuffer<Keystroke>& getKeystrokes() const { return mKeystrokes; }
+	void setKeystrokeCapacity(int capacity);
+
 signals:
 	void startChanged();
 	void elapsedChanged();
+	void elapsedResolutionChanged();
 	void hitsChanged();
 	void missesChanged();
 
@@ -65,23 +94,33 @@ signals:
 public slots:
 	void reset();
 	void pause();
-	void hit();
-	void unhit();
-	void miss();
-	void unmiss();
+	void hit(QChar expected = QChar(), QChar typed = QChar());
+	void unhit(QChar expected = QChar(), QChar typed = QChar());
+	void miss(QChar expected = QChar(), QChar typed = QChar());
+	void unmiss(QChar expected = QChar(), QChar typed = QChar());
 
 private:
-	void timeout();
+	void tick();
 	void resume();
+	inline void record(Keystroke::Type type, QChar expected, QChar typed)
+	{
+		mKeystrokes.push_back(Keystroke { mClock.nsecsElapsed(), expected, typed, type });
+	}
 
-	QTimer* mStatsTimer;
-	QTimer* mPauseTimer;
+	QTimer* mNotifyTimer;
 	QTimer* mHintTimer;
 
 	QDateTime mStart;
-	int mElapsed = 0;
+	/* Active time of the finished periods in ns */
+	qint64 mActiveNs = 0;
+	/* Start of the current period or -1 when paused */
+	qint64 mResumedAt = -1;
+	qint64 mLastKeyAt = 0;
 	int mHits = 0;
 	int mMisses = 0;
+
+	QElapsedTimer mClock;
+	RingBuffer<Keystroke> mKeystrokes;
 };
 
 } /* namespace qtouch */
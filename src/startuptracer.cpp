@@ -0,0 +1,274 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file startuptracer.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "startuptracer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+
+#include <QDebug>
+
+namespace qtouch
+{
+
+const char* StartupTracer::OPTION = "--trace-startup";
+
+StartupTracer& StartupTracer::instance()
+{
+	static StartupTracer tracer;
+	return tracer;
+}
+
+/**
+ * Find the trace file in the command line.
+ * Parsed before the application object exists to include its construction.
+ * @return The file name passed by --trace-startup=<file> or --trace-startup <file>.
+ */
+QString StartupTracer::fileFromArguments(int argc, char* argv[])
+{
+	const std::size_t length = std::strlen(OPTION);
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strncmp(argv[i], OPTION, length) != 0)
+			continue;
+
+		if (argv[i][length] == '=')
+			return QString::fromLocal8Bit(argv[i] + length + 1);
+		if (argv[i][length] == '\0' && i + 1 < argc)
+			return QString::fromLocal8Bit(argv[i + 1]);
+	}
+	return QString();
+}
+
+StartupTracer::StartupTracer() :
+	mEnabled(false)
+{
+	mClock.start();
+}
+
+void StartupTracer::setEnabled(bool enabled)
+{
+	mEnabled = enabled;
+}
+
+/** Nanoseconds since the tracer was created */
+qint64 StartupTracer::now() const
+{
+	return mClock.nsecsElapsed();
+}
+
+/**
+ * Begin a span on the current thread. Must be ended on the same thread.
+ * @param name A string literal.
+ * @param detail Distinguishes spans of the same name, e.g. a file name.
+ */
+void StartupTracer::begin(const char* name, const QString& detail)
+{
+	if (!mEnabled)
+		return;
+
+	qint64 start = now();
+
+	QMutexLocker lock(&mMutex);
+	int thread = threadIndex();
+	mOpen[thread].push_back(mEvents.size());
+	mEvents.push_back(Event { name, detail, thread, static_cast<int>(mOpen[thread].size()) - 1, start, 0 });
+}
+
+/** End the innermost span of the current thread */
+void StartupTracer::end()
+{
+	if (!mEnabled)
+		return;
+
+	qint64 end = now();
+
+	QMutexLocker lock(&mMutex);
+	int thread = threadIndex();
+	if (mOpen[thread].empty())
+		return;
+
+	Event& e = mEvents[mOpen[thread].back()];
+	e.durationNs = end - e.startNs;
+	mOpen[thread].pop_back();
+}
+
+/**
+ * Add a span that began and ended at different places, e.g. in different threads.
+ * @param name A string literal.
+ * @param startNs The start as returned by now().
+ * @param endNs The end as returned by now().
+ */
+void StartupTracer::addSpan(const char* name, qint64 startNs, qint64 endNs)
+{
+	if (!mEnabled)
+		return;
+
+	QMutexLocker lock(&mMutex);
+	mEvents.push_back(Event { name, QString(), threadIndex(), 0, startNs, endNs - startNs });
+}
+
+/** Mark a point in time, e.g. the first frame */
+void StartupTracer::addInstant(const char* name)
+{
+	if (!mEnabled)
+		return;
+
+	qint64 start = now();
+
+	QMutexLocker lock(&mMutex);
+	int thread = threadIndex();
+	mEvents.push_back(Event { name, QString(), thread, static_cast<int>(mOpen[thread].size()), start, -1 });
+}
+
+/* Called with the lock held */
+int StartupTracer::threadIndex()
+{
+	Qt::HANDLE id = QThread::currentThreadId();
+	auto it = std::find(mThreads.begin(), mThreads.end(), id);
+	if (it != mThreads.end())
+		return static_cast<int>(it - mThreads.begin());
+
+	mThreads.push_back(id);
+	mOpen.emplace_back();
+	return static_cast<int>(mThreads.size()) - 1;
+}
+
+/**
+ * Format the events as a table ordered by their start.
+ * Times are given in ms. Nested spans are indented.
+ * @return The table.
+ */
+QString StartupTracer::summary() const
+{
+	QMutexLocker lock(&mMutex);
+
+	std::vector<const Event*> sorted;
+	for (const Event& e : mEvents)
+		sorted.push_back(&e);
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Event* lhs, const Event* rhs)
+	{
+		return lhs->startNs < rhs->startNs;
+	});
+
+	QString out;
+	QTextStream s(&out);
+
+	s << "Startup trace:\n";
+	s << QString("%1 %2 %3  %4\n").arg("start", 10).arg("duration", 10).arg("thread", 6).arg("span");
+
+	for (const Event* e : sorted)
+	{
+		QString name = QString(2 * e->depth, ' ') + QString::fromLatin1(e->name);
+		if (!e->detail.isEmpty())
+			name += QStringLiteral(" (") + e->detail + ')';
+
+		s << QString("%1 %2 %3  %4\n").arg(e->startNs / 1e6, 10, 'f', 2)
+		  .arg(e->durationNs < 0 ? QStringLiteral("-") : QString::number(e->durationNs / 1e6, 'f', 2), 10)
+		  .arg(e->thread, 6).arg(name);
+	}
+
+	s.flush();
+	return out;
+}
+
+/**
+ * Format the events in the Chrome trace-event format.
+ * Spans are complete events ("X"), instants are global instant events ("i").
+ * @return The JSON document.
+ */
+QByteArray StartupTracer::chromeTrace() const
+{
+	QMutexLocker lock(&mMutex);
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	QJsonArray events;
+
+	for (const Event& e : mEvents)
+	{
+		QJsonObject o;
+		o["name"] = QString::fromLatin1(e.name);
+		o["cat"] = QStringLiteral("startup");
+		o["pid"] = pid;
+		o["tid"] = e.thread;
+		o["ts"] = e.startNs / 1e3;
+
+		if (e.durationNs < 0)
+		{
+			o["ph"] = QStringLiteral("i");
+			o["s"] = QStringLiteral("g");
+		}
+		else
+		{
+			o["ph"] = QStringLiteral("X");
+			o["dur"] = e.durationNs / 1e3;
+		}
+
+		if (!e.detail.isEmpty())
+			o["args"] = QJsonObject { { QStringLiteral("detail"), e.detail } };
+
+		events.append(o);
+	}
+
+	QJsonObject root;
+	root["traceEvents"] = events;
+	root["displayTimeUnit"] = QStringLiteral("ms");
+	return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+/**
+ * Write the trace.
+ * @param fileName A file name ending with .json for the Chrome trace, otherwise the summary is written.
+ * @return false on error.
+ */
+bool StartupTracer::write(const QString& fileName) const
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qWarning() << "Unable to write startup trace to" << fileName;
+		return false;
+	}
+
+	if (fileName.endsWith(QLatin1String(".json"), Qt::CaseInsensitive))
+		file.write(chromeTrace());
+	else
+		file.write(summary().toUtf8());
+
+	return true;
+}
+
+} /* namespace qtouch */
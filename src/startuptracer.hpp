@@ -0,0 +1,122 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file startuptracer.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef STARTUPTRACER_HPP_
+#define STARTUPTRACER_HPP_
+
+#include <atomic>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+namespace qtouch
+{
+
+/**
+ * Records nested spans of the startup from any thread.
+ * Spans are nested per thread by the order they begin and end. The result is
+ * written as Chrome trace-event JSON (load it in chrome://tracing) when the
+ * file name ends with .json, as a table otherwise.\n
+ * Disabled by default, a disabled tracer costs a single branch per span.
+ */
+class StartupTracer
+{
+public:
+	/** Command-line option that takes the file name of the trace. */
+	static const char* OPTION;
+
+	static StartupTracer& instance();
+	static QString fileFromArguments(int argc, char* argv[]);
+
+	inline bool isEnabled() const { return mEnabled; }
+	void setEnabled(bool enabled);
+
+	qint64 now() const;
+
+	void begin(const char* name, const QString& detail = QString());
+	void end();
+	void addSpan(const char* name, qint64 startNs, qint64 endNs);
+	void addInstant(const char* name);
+
+	QString summary() const;
+	QByteArray chromeTrace() const;
+	bool write(const QString& fileName) const;
+
+private:
+	struct Event
+	{
+		const char* name;
+		QString detail;
+		int thread;
+		int depth;
+		qint64 startNs;
+		/* -1 for instants */
+		qint64 durationNs;
+	};
+
+	StartupTracer();
+	int threadIndex();
+
+	std::atomic<bool> mEnabled;
+	QElapsedTimer mClock;
+
+	/* Guards everything below */
+	mutable QMutex mMutex;
+	std::vector<Event> mEvents;
+	/* Per thread: Indexes into mEvents of the spans that are open */
+	std::vector<std::vector<std::size_t>> mOpen;
+	std::vector<Qt::HANDLE> mThreads;
+};
+
+/** Traces the lifetime of a scope. */
+class TraceSpan
+{
+public:
+	explicit TraceSpan(const char* name, const QString& detail = QString()) :
+		mActive(StartupTracer::instance().isEnabled())
+	{
+		if (mActive)
+			StartupTracer::instance().begin(name, detail);
+	}
+
+	~TraceSpan()
+	{
+		if (mActive)
+			StartupTracer::instance().end();
+	}
+
+private:
+	Q_DISABLE_COPY(TraceSpan)
+
+	bool mActive;
+};
+
+} /* namespace qtouch */
+
+#endif /* STARTUPTRACER_HPP_ */
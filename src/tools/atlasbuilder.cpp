@@ -0,0 +1,341 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file atlasbuilder.cpp
+ *
+ * Pre-rasterizes SVG elements at a set of sizes into a single texture atlas.
+ * The index is read by qtouch::SvgAtlas. Each line describes one sprite:
+ * <resource name> <element id> <width> <height> <x> <y> <item width> <item height>
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QImage>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QStringBuilder>
+
+#include <QDebug>
+
+/* Pickup arguments:
+ * -o . -s 64,128 ../resources images/meter.svgz#ring,scale images/clock.svgz#face
+ */
+
+namespace
+{
+
+enum CommandLineParseResult
+{
+	CommandLineOk, CommandLineError, CommandLineVersionRequested, CommandLineHelpRequested
+};
+
+struct Config
+{
+	bool verbose;
+	QString outputDir;
+	QString baseName;
+	QList<int> sizes;
+	int maxWidth;
+	QString rootDir;
+	/* Resource name -> Element ids */
+	std::vector<std::pair<QString, QStringList>> files;
+};
+
+struct Sprite
+{
+	QString name;
+	QString elementId;
+	QImage image;
+	QSize itemSize;
+	QPoint position;
+};
+
+/* Empty pixels between sprites avoid bleeding when the textures are filtered */
+const int PADDING = 1;
+
+QTextStream& qStdOut()
+{
+	static QTextStream std(stdout);
+	return std;
+}
+
+CommandLineParseResult parseCommandLine(QCommandLineParser& parser, Config* config, QString* errorMessage)
+{
+	const QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory", "directory", ".");
+	parser.addOption(outputOption);
+
+	const QCommandLineOption nameOption(QStringList() << "n" << "name", "Base name of the atlas files", "name",
+	                                    "svgatlas");
+	parser.addOption(nameOption);
+
+	const QCommandLineOption sizesOption(QStringList() << "s" << "sizes", "Comma separated square sizes in pixels",
+	                                     "sizes", "64,128,256");
+	parser.addOption(sizesOption);
+
+	const QCommandLineOption widthOption(QStringList() << "w" << "width", "Maximum width of the atlas", "pixels",
+	                                     "2048");
+	parser.addOption(widthOption);
+
+	const QCommandLineOption verboseOption(QStringList() << "V" << "verbose", "Be verbose");
+	parser.addOption(verboseOption);
+
+	parser.addPositionalArgument("root", "Resource root directory");
+	parser.addPositionalArgument("files", "Resource names with the element ids, e.g. images/meter.svgz#ring,hand",
+	                             "files...");
+
+	const QCommandLineOption helpOption = parser.addHelpOption();
+	const QCommandLineOption versionOption = parser.addVersionOption();
+
+	if (!parser.parse(QCoreApplication::arguments()))
+	{
+		*errorMessage = parser.errorText();
+		return CommandLineError;
+	}
+
+	if (parser.isSet(versionOption))
+		return CommandLineVersionRequested;
+
+	if (parser.isSet(helpOption))
+		return CommandLineHelpRequested;
+
+	config->verbose = parser.isSet(verboseOption);
+	config->outputDir = parser.value(outputOption);
+	config->baseName = parser.value(nameOption);
+
+	for (const QString& s : parser.value(sizesOption).split(',', QString::SkipEmptyParts))
+	{
+		bool ok = false;
+		int size = s.trimmed().toInt(&ok);
+		if (!ok || size <= 0)
+		{
+			*errorMessage = QStringLiteral("Invalid size: ") % s;
+			return CommandLineError;
+		}
+		config->sizes.append(size);
+	}
+
+	bool ok = false;
+	config->maxWidth = parser.value(widthOption).toInt(&ok);
+	if (!ok || config->maxWidth <= 0)
+	{
+		*errorMessage = QStringLiteral("Invalid width: ") % parser.value(widthOption);
+		return CommandLineError;
+	}
+
+	const QStringList args = parser.positionalArguments();
+
+	if (args.size() < 2)
+	{
+		*errorMessage = "Invalid number of arguments.";
+		return CommandLineError;
+	}
+
+	config->rootDir = args.at(0);
+	if (!QDir(config->rootDir).exists())
+	{
+		*errorMessage = QStringLiteral("Invalid root directory: ") % config->rootDir;
+		return CommandLineError;
+	}
+
+	for (int i = 1; i < args.size(); ++i)
+	{
+		int hash = args.at(i).indexOf('#');
+		QString name = args.at(i).left(hash);
+		QStringList ids = (hash < 0) ? QStringList() : args.at(i).mid(hash + 1).split(',', QString::SkipEmptyParts);
+		if (ids.isEmpty())
+		{
+			*errorMessage = QStringLiteral("No element ids given for: ") % name;
+			return CommandLineError;
+		}
+		config->files.push_back(std::make_pair(name, ids));
+	}
+
+	return CommandLineOk;
+}
+
+/* Shelf packing: Sprites are sorted by height and placed in rows */
+QSize pack(std::vector<Sprite>& sprites, int maxWidth)
+{
+	std::stable_sort(sprites.begin(), sprites.end(), [](const Sprite& lhs, const Sprite& rhs)
+	{
+		return lhs.image.height() > rhs.image.height();
+	});
+
+	int x = 0;
+	int y = 0;
+	int rowHeight = 0;
+	int width = 0;
+
+	for (Sprite& s : sprites)
+	{
+		if (x > 0 && x + s.image.width() > maxWidth)
+		{
+			x = 0;
+			y += rowHeight + PADDING;
+			rowHeight = 0;
+		}
+
+		s.position = QPoint(x, y);
+		x += s.image.width() + PADDING;
+		rowHeight = std::max(rowHeight, s.image.height());
+		width = std::max(width, x - PADDING);
+	}
+
+	return QSize(width, y + rowHeight);
+}
+
+} /* anonymous namespace */
+
+int main(int argc, char* argv[])
+{
+	// Runs during the build without a display
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QGuiApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("atlasbuilder"));
+	QCoreApplication::setApplicationVersion(QStringLiteral("v1.0") % " (Qt " % QT_VERSION_STR % ")");
+
+	// Parse options
+	QCommandLineParser parser;
+	parser.setApplicationDescription(
+	    QStringLiteral("This tool pre-rasterizes SVG elements into a texture atlas that is loaded by QTouch."));
+
+	Config c;
+	QString errorMsg;
+
+	switch (parseCommandLine(parser, &c, &errorMsg))
+	{
+	case CommandLineOk:
+		break;
+	case CommandLineError:
+		fputs(qPrintable(errorMsg), stderr);
+		fputs("\n\n", stderr);
+		fputs(qPrintable(parser.helpText()), stderr);
+		return 1;
+	case CommandLineVersionRequested:
+		printf("%s %s\n", qPrintable(QCoreApplication::applicationName()),
+		       qPrintable(QCoreApplication::applicationVersion()));
+		return 0;
+	case CommandLineHelpRequested:
+		parser.showHelp();
+		Q_UNREACHABLE();
+	}
+
+	std::vector<Sprite> sprites;
+	const QDir root(c.rootDir);
+
+	for (const auto& file : c.files)
+	{
+		QSvgRenderer renderer;
+		if (!renderer.load(root.filePath(file.first)))
+		{
+			qCritical() << "Unable to load image:" << root.filePath(file.first);
+			return 1;
+		}
+
+		for (const QString& id : file.second)
+		{
+			if (!renderer.elementExists(id))
+			{
+				qCritical() << "Unable to find element" << id << "in image" << file.first;
+				return 1;
+			}
+
+			QSize itemSize = renderer.boundsOnElement(id).size().toSize();
+
+			// Rendered like the SvgElementProvider does: The element fills the requested size
+			for (int size : c.sizes)
+			{
+				Sprite s;
+				s.name = file.first;
+				s.elementId = id;
+				s.itemSize = itemSize;
+				s.image = QImage(size, size, QImage::Format_ARGB32_Premultiplied);
+				s.image.fill(Qt::transparent);
+
+				QPainter p(&s.image);
+				renderer.render(&p, id);
+				p.end();
+
+				sprites.push_back(s);
+			}
+		}
+	}
+
+	QSize atlasSize = pack(sprites, c.maxWidth);
+
+	QImage atlas(atlasSize, QImage::Format_ARGB32_Premultiplied);
+	atlas.fill(Qt::transparent);
+
+	QPainter p(&atlas);
+	p.setCompositionMode(QPainter::CompositionMode_Source);
+	for (const Sprite& s : sprites)
+		p.drawImage(s.position, s.image);
+	p.end();
+
+	QDir output(c.outputDir);
+	if (!output.exists() && !output.mkpath("."))
+	{
+		qCritical() << "Unable to create output directory" << c.outputDir;
+		return 1;
+	}
+
+	const QString imageFile = output.filePath(c.baseName % ".png");
+	if (!atlas.save(imageFile, "PNG"))
+	{
+		qCritical() << "Unable to write" << imageFile;
+		return 1;
+	}
+
+	const QString indexFile = output.filePath(c.baseName % ".index");
+	QFile index(indexFile);
+	if (!index.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		qCritical() << "Unable to write" << indexFile;
+		return 1;
+	}
+
+	QTextStream s(&index);
+	for (const Sprite& sprite : sprites)
+	{
+		s << sprite.name << ' ' << sprite.elementId << ' ' << sprite.image.width() << ' ' << sprite.image.height() << ' '
+		  << sprite.position.x() << ' ' << sprite.position.y() << ' '
+		  << sprite.itemSize.width() << ' ' << sprite.itemSize.height() << '\n';
+	}
+
+	if (c.verbose)
+	{
+		qStdOut() << sprites.size() << " sprites written to " << imageFile << " (" << atlasSize.width() << "x"
+		          << atlasSize.height() << ")\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file typingstate.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "typingstate.hpp"
+
+namespace qtouch
+{
+
+/**
+ * Set a new text and start over.
+ * @param text The text to type.
+ */
+void TypingState::reset(const QString& text)
+{
+	mCells.clear();
+	mCells.reserve(text.size());
+	for (const QChar& c : text)
+		mCells.push_back(Cell { c, QChar(), Untyped, false });
+
+	mRuns.clear();
+	mPosition = 0;
+	mFurthest = 0;
+}
+
+/**
+ * Start over with the current text.
+ */
+void TypingState::restart()
+{
+	for (Cell& c : mCells)
+	{
+		c.typed = QChar();
+		c.state = Untyped;
+		c.counted = false;
+	}
+
+	mRuns.clear();
+	mPosition = 0;
+	mFurthest = 0;
+}
+
+/**
+ * Limit how far the user may go back behind the furthest typed position.
+ * @param limit The number of characters or 0 for no limit.
+ */
+void TypingState::setCorrectionLimit(int limit)
+{
+	mCorrectionLimit = limit > 0 ? limit : 0;
+}
+
+/**
+ * Type the next character.
+ * @param typed The typed character.
+ * @param counted Whether the key is passed to the statistics.
+ * @return Hit if it matches the expected character, Miss otherwise and
+ * Untyped if the end of the text is already reached.
+ */
+TypingState::State TypingState::advance(QChar typed, bool counted)
+{
+	if (atEnd())
+		return Untyped;
+
+	Cell& c = mCells[mPosition];
+	c.typed = typed;
+	c.state = (typed == c.expected) ? Hit : Miss;
+	c.counted = counted;
+
+	if (!mRuns.empty() && mRuns.back().state == c.state)
+		++mRuns.back().length;
+	else
+		mRuns.push_back(Run { mPosition, 1, c.state });
+
+	++mPosition;
+	if (mPosition > mFurthest)
+		mFurthest = mPosition;
+	return c.state;
+}
+
+/**
+ * Take back the last typed character.
+ * @return The cell as it was before; its state is Untyped if the correction
+ * limit or the start is reached.
+ */
+TypingState::Cell TypingState::retreat()
+{
+	if (!canRetreat())
+		return Cell { expected(), QChar(), Untyped, false };
+
+	--mPosition;
+	Cell& c = mCells[mPosition];
+	Cell before = c;
+	c.typed = QChar();
+	c.state = Untyped;
+	c.counted = false;
+
+	if (--mRuns.back().length == 0)
+		mRuns.pop_back();
+
+	return before;
+}
+
+} /* namespace qtouch */
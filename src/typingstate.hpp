@@ -0,0 +1,100 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file typingstate.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef TYPINGSTATE_HPP_
+#define TYPINGSTATE_HPP_
+
+#include <vector>
+#include <QString>
+
+namespace qtouch
+{
+
+/**
+ * Progress of the user through a lesson text.
+ * Holds one cell per character of the text and the runs of equally typed
+ * characters the renderer needs. Advancing and going back are O(1).
+ * The cells are the correction history: They are allocated once per text and
+ * remember what was typed at each position and if it was counted.
+ */
+class TypingState
+{
+public:
+	enum State : quint8 { Untyped, Hit, Miss };
+
+	struct Cell
+	{
+		QChar expected;
+		QChar typed;
+		State state;
+		/** Whether the key was passed to the statistics */
+		bool counted;
+	};
+
+	/** Consecutive typed characters with the same state. */
+	struct Run
+	{
+		int start;
+		int length;
+		State state;
+	};
+
+	void reset(const QString& text);
+	void restart();
+
+	inline int size() const { return static_cast<int>(mCells.size()); }
+	inline int position() const { return mPosition; }
+	inline bool atEnd() const { return mPosition >= size(); }
+	inline const Cell& at(int i) const { return mCells.at(i); }
+	/** The character to type next or a null char at the end. */
+	inline QChar expected() const { return atEnd() ? QChar() : mCells[mPosition].expected; }
+
+	/** The number of characters the user may go back or 0 for no limit. */
+	inline int getCorrectionLimit() const { return mCorrectionLimit; }
+	void setCorrectionLimit(int limit);
+	/** The position retreat() stops at. */
+	inline int correctionFloor() const { return mCorrectionLimit > 0 && mFurthest > mCorrectionLimit ? mFurthest - mCorrectionLimit : 0; }
+	inline bool canRetreat() const { return mPosition > correctionFloor(); }
+
+	State advance(QChar typed, bool counted = true);
+	Cell retreat();
+
+	/** The runs covering the typed text from the start to position(). */
+	inline const std::vector<Run>& getRuns() const { return mRuns; }
+
+private:
+	std::vector<Cell> mCells;
+	std::vector<Run> mRuns;
+	int mPosition = 0;
+	/* The highest position reached since the start */
+	int mFurthest = 0;
+	int mCorrectionLimit = 0;
+};
+
+} /* namespace qtouch */
+
+#endif /* TYPINGSTATE_HPP_ */
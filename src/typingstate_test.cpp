@@ -0,0 +1,369 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file typingstate_test.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <QtTest/QtTest>
+
+#include "typingstate.hpp"
+
+namespace qtouch
+{
+
+class TypingStateTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void init();
+
+	void initialization();
+	void advance();
+	void advanceAtEnd();
+	void retreat();
+	void retreatAtStart();
+	void mergeRuns();
+	void splitRuns();
+	void miss();
+	void restart();
+	void correctionFloor();
+	void correctionFloorAfterRetype();
+	void noCorrectionLimit();
+	void countedOnce();
+	void notCounted();
+
+private:
+	TypingState uut;
+
+	void compare(const TypingState::Run& run, int start, int length, TypingState::State state);
+};
+
+const QString text = QStringLiteral("asdf");
+
+void TypingStateTest::init()
+{
+	uut = TypingState();
+	uut.reset(text);
+}
+
+/* Number of cells passed to the statistics */
+int countedCells(const TypingState& state)
+{
+	int count = 0;
+	for (int i = 0; i < state.size(); ++i)
+		count += state.at(i).counted ? 1 : 0;
+	return count;
+}
+
+void TypingStateTest::initialization()
+{
+	QCOMPARE(uut.size(), text.size());
+	QCOMPARE(uut.position(), 0);
+	QVERIFY(!uut.atEnd());
+	QVERIFY(!uut.canRetreat());
+	QCOMPARE(uut.expected(), QChar('a'));
+	QVERIFY(uut.getRuns().empty());
+
+	for (int i = 0; i < uut.size(); ++i)
+	{
+		QCOMPARE(uut.at(i).expected, text.at(i));
+		QCOMPARE(uut.at(i).state, TypingState::Untyped);
+	}
+}
+
+void TypingStateTest::advance()
+{
+	QCOMPARE(uut.advance(QChar('a')), TypingState::Hit);
+	QCOMPARE(uut.position(), 1);
+	QCOMPARE(uut.expected(), QChar('s'));
+	QVERIFY(uut.canRetreat());
+
+	QCOMPARE(uut.at(0).typed, QChar('a'));
+	QCOMPARE(uut.at(0).state, TypingState::Hit);
+	QVERIFY(uut.at(0).counted);
+}
+
+void TypingStateTest::advanceAtEnd()
+{
+	for (const QChar& c : text)
+		QCOMPARE(uut.advance(c), TypingState::Hit);
+
+	QVERIFY(uut.atEnd());
+	QCOMPARE(uut.position(), text.size());
+	QVERIFY(uut.expected().isNull());
+
+	// Nothing changes behind the end
+	QCOMPARE(uut.advance(QChar('x')), TypingState::Untyped);
+	QCOMPARE(uut.position(), text.size());
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(1));
+	compare(uut.getRuns().back(), 0, text.size(), TypingState::Hit);
+}
+
+void TypingStateTest::retreat()
+{
+	uut.advance(QChar('a'));
+	uut.advance(QChar('s'));
+
+	TypingState::Cell before = uut.retreat();
+	QCOMPARE(before.expected, QChar('s'));
+	QCOMPARE(before.typed, QChar('s'));
+	QCOMPARE(before.state, TypingState::Hit);
+	QVERIFY(before.counted);
+
+	QCOMPARE(uut.position(), 1);
+	QCOMPARE(uut.expected(), QChar('s'));
+	QCOMPARE(uut.at(1).state, TypingState::Untyped);
+	QVERIFY(uut.at(1).typed.isNull());
+	QVERIFY(!uut.at(1).counted);
+
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(1));
+	compare(uut.getRuns().back(), 0, 1, TypingState::Hit);
+
+	// Retreat from the end
+	uut.advance(QChar('s'));
+	uut.advance(QChar('d'));
+	uut.advance(QChar('f'));
+	QVERIFY(uut.atEnd());
+
+	before = uut.retreat();
+	QCOMPARE(before.expected, QChar('f'));
+	QVERIFY(!uut.atEnd());
+	QCOMPARE(uut.expected(), QChar('f'));
+	compare(uut.getRuns().back(), 0, 3, TypingState::Hit);
+}
+
+void TypingStateTest::retreatAtStart()
+{
+	TypingState::Cell before = uut.retreat();
+	QCOMPARE(before.state, TypingState::Untyped);
+	QCOMPARE(before.expected, QChar('a'));
+	QCOMPARE(uut.position(), 0);
+
+	uut.advance(QChar('a'));
+	uut.retreat();
+	QVERIFY(!uut.canRetreat());
+	QVERIFY(uut.getRuns().empty());
+
+	before = uut.retreat();
+	QCOMPARE(before.state, TypingState::Untyped);
+	QCOMPARE(uut.position(), 0);
+	QVERIFY(uut.getRuns().empty());
+}
+
+void TypingStateTest::mergeRuns()
+{
+	uut.advance(QChar('a'));
+	uut.advance(QChar('s'));
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(1));
+	compare(uut.getRuns().back(), 0, 2, TypingState::Hit);
+
+	uut.advance(QChar('x'));
+	uut.advance(QChar('y'));
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(2));
+	compare(uut.getRuns().front(), 0, 2, TypingState::Hit);
+	compare(uut.getRuns().back(), 2, 2, TypingState::Miss);
+
+	// Correcting the misses merges the runs again
+	uut.retreat();
+	uut.retreat();
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(1));
+	uut.advance(QChar('d'));
+	uut.advance(QChar('f'));
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(1));
+	compare(uut.getRuns().back(), 0, 4, TypingState::Hit);
+}
+
+void TypingStateTest::splitRuns()
+{
+	for (const QChar& c : text)
+		uut.advance(c);
+
+	// Replace the hit in the middle by a miss
+	uut.retreat();
+	uut.retreat();
+	uut.advance(QChar('x'));
+	uut.advance(QChar('f'));
+
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(3));
+	compare(uut.getRuns().at(0), 0, 2, TypingState::Hit);
+	compare(uut.getRuns().at(1), 2, 1, TypingState::Miss);
+	compare(uut.getRuns().at(2), 3, 1, TypingState::Hit);
+
+	// The runs shrink from the back
+	uut.retreat();
+	QCOMPARE(uut.getRuns().size(), static_cast<std::size_t>(2));
+	compare(uut.getRuns().back(), 2, 1, TypingState::Miss);
+}
+
+void TypingStateTest::miss()
+{
+	QCOMPARE(uut.advance(QChar('q')), TypingState::Miss);
+
+	// The position moves on, the expected and the typed char are kept
+	QCOMPARE(uut.position(), 1);
+	QCOMPARE(uut.at(0).expected, QChar('a'));
+	QCOMPARE(uut.at(0).typed, QChar('q'));
+	QCOMPARE(uut.at(0).state, TypingState::Miss);
+
+	TypingState::Cell before = uut.retreat();
+	QCOMPARE(before.expected, QChar('a'));
+	QCOMPARE(before.typed, QChar('q'));
+	QCOMPARE(before.state, TypingState::Miss);
+}
+
+void TypingStateTest::restart()
+{
+	uut.advance(QChar('a'));
+	uut.advance(QChar('x'));
+
+	uut.restart();
+	QCOMPARE(uut.size(), text.size());
+	QCOMPARE(uut.position(), 0);
+	QVERIFY(uut.getRuns().empty());
+	QVERIFY(!uut.canRetreat());
+	for (int i = 0; i < uut.size(); ++i)
+	{
+		QCOMPARE(uut.at(i).state, TypingState::Untyped);
+		QVERIFY(uut.at(i).typed.isNull());
+		QVERIFY(!uut.at(i).counted);
+	}
+}
+
+void TypingStateTest::correctionFloor()
+{
+	uut.setCorrectionLimit(2);
+	QCOMPARE(uut.getCorrectionLimit(), 2);
+	QCOMPARE(uut.correctionFloor(), 0);
+
+	for (const QChar& c : text)
+		uut.advance(c);
+	QCOMPARE(uut.correctionFloor(), 2);
+
+	QCOMPARE(uut.retreat().state, TypingState::Hit);
+	QCOMPARE(uut.retreat().state, TypingState::Hit);
+	QVERIFY(!uut.canRetreat());
+
+	// Backspace stops at the floor
+	TypingState::Cell before = uut.retreat();
+	QCOMPARE(before.state, TypingState::Untyped);
+	QCOMPARE(before.expected, QChar('d'));
+	QCOMPARE(uut.position(), 2);
+	QCOMPARE(uut.at(1).state, TypingState::Hit);
+	compare(uut.getRuns().back(), 0, 2, TypingState::Hit);
+}
+
+void TypingStateTest::correctionFloorAfterRetype()
+{
+	uut.setCorrectionLimit(2);
+
+	for (const QChar& c : text)
+		uut.advance(c);
+
+	// Retyping behind the furthest position does not move the floor back
+	uut.retreat();
+	uut.retreat();
+	uut.advance(QChar('d'));
+	QCOMPARE(uut.correctionFloor(), 2);
+	uut.retreat();
+	QVERIFY(!uut.canRetreat());
+	QCOMPARE(uut.position(), 2);
+}
+
+void TypingStateTest::noCorrectionLimit()
+{
+	// 0 and negative limits disable the limit
+	uut.setCorrectionLimit(0);
+	QCOMPARE(uut.getCorrectionLimit(), 0);
+	uut.setCorrectionLimit(-1);
+	QCOMPARE(uut.getCorrectionLimit(), 0);
+
+	for (const QChar& c : text)
+		uut.advance(c);
+	QCOMPARE(uut.correctionFloor(), 0);
+
+	while (uut.canRetreat())
+		uut.retreat();
+	QCOMPARE(uut.position(), 0);
+	QVERIFY(uut.getRuns().empty());
+
+	// A limit beyond the text never applies
+	uut.setCorrectionLimit(text.size());
+	for (const QChar& c : text)
+		uut.advance(c);
+	QCOMPARE(uut.correctionFloor(), 0);
+
+	while (uut.canRetreat())
+		uut.retreat();
+	QCOMPARE(uut.position(), 0);
+}
+
+void TypingStateTest::countedOnce()
+{
+	uut.advance(QChar('a'));
+	uut.advance(QChar('x'));
+	QCOMPARE(countedCells(uut), 2);
+
+	// The retreat hands back what was counted, so the caller can take it back
+	TypingState::Cell before = uut.retreat();
+	QVERIFY(before.counted);
+	QCOMPARE(countedCells(uut), 1);
+
+	uut.advance(QChar('s'));
+	QCOMPARE(countedCells(uut), 2);
+
+	// Retreat and retype several times: Never more than one count per cell
+	for (int i = 0; i < 3; ++i)
+	{
+		QVERIFY(uut.retreat().counted);
+		QVERIFY(uut.retreat().counted);
+		QCOMPARE(countedCells(uut), 0);
+		uut.advance(QChar('a'));
+		uut.advance(QChar('s'));
+		QCOMPARE(countedCells(uut), 2);
+	}
+}
+
+void TypingStateTest::notCounted()
+{
+	uut.advance(QChar('a'), false);
+	QVERIFY(!uut.at(0).counted);
+	QCOMPARE(countedCells(uut), 0);
+
+	// Nothing to take back
+	TypingState::Cell before = uut.retreat();
+	QCOMPARE(before.state, TypingState::Hit);
+	QVERIFY(!before.counted);
+}
+
+void TypingStateTest::compare(const TypingState::Run& run, int start, int length, TypingState::State state)
+{
+	QCOMPARE(run.start, start);
+	QCOMPARE(run.length, length);
+	QCOMPARE(run.state, state);
+}
+
+} /* namespace qtouch */
+
+QTEST_GUILESS_MAIN(qtouch::TypingStateTest)
+#include "typingstate_test.moc"
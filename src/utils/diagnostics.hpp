@@ -0,0 +1,97 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file diagnostics.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef DIAGNOSTICS_HPP_
+#define DIAGNOSTICS_HPP_
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QTextStream>
+#include <QtGlobal>
+
+#include <QDebug>
+
+namespace qtouch
+{
+
+/**
+ * Helpers for the diagnostics that are switched on by environment variables,
+ * e.g. QTOUCH_DB_STATS. Reports go through qInfo() or into a file since
+ * release builds compile out qDebug().
+ */
+namespace diagnostics
+{
+
+/**
+ * Check if a diagnostics variable is set.
+ * @param envVar Name of the environment variable.
+ * @return false if unset, empty or "0".
+ */
+inline bool isEnabled(const char* envVar)
+{
+	QByteArray value = qgetenv(envVar);
+	return !value.isEmpty() && value != "0";
+}
+
+/**
+ * Publish the report of the diagnostics enabled by the given variable.
+ * The value "1" prints the report with qInfo(), any other value is taken
+ * as the name of a file the report is appended to.
+ * @param envVar Name of the environment variable.
+ * @param report The report.
+ * @return false if disabled or the file cannot be written.
+ */
+inline bool report(const char* envVar, const QString& report)
+{
+	if (!isEnabled(envVar))
+		return false;
+
+	QByteArray value = qgetenv(envVar);
+	if (value == "1")
+	{
+		qInfo().noquote() << report;
+		return true;
+	}
+
+	QFile file(QString::fromLocal8Bit(value));
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+	{
+		qWarning() << "Unable to write" << envVar << "report to" << file.fileName() << ":" << file.errorString();
+		return false;
+	}
+
+	QTextStream s(&file);
+	s << report << "\n";
+	return true;
+}
+
+} /* namespace diagnostics */
+
+} /* namespace qtouch */
+
+#endif /* DIAGNOSTICS_HPP_ */
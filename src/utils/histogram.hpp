@@ -0,0 +1,105 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file histogram.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef HISTOGRAM_HPP_
+#define HISTOGRAM_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace qtouch
+{
+
+/**
+ * Histogram with buckets of equal width for non negative values.
+ * Values beyond the last bucket are counted in an overflow bucket.
+ * The storage is allocated on construction, so add() never allocates.
+ */
+class Histogram
+{
+public:
+	Histogram(int64_t bucketWidth, int buckets) :
+		mWidth(bucketWidth > 0 ? bucketWidth : 1), mBuckets((buckets > 0 ? buckets : 1) + 1, 0) {}
+
+	void add(int64_t value)
+	{
+		if (value < 0)
+			value = 0;
+
+		++mCount;
+		mSum += value;
+		mMax = std::max(mMax, value);
+		++mBuckets[std::min<uint64_t>(value / mWidth, mBuckets.size() - 1)];
+	}
+
+	inline uint64_t count() const { return mCount; }
+	inline int64_t max() const { return mMax; }
+	inline double mean() const { return mCount ? static_cast<double>(mSum) / mCount : 0; }
+
+	/**
+	 * Estimate a percentile.
+	 * @param p The percentile in the range [0,1].
+	 * @return The upper bound of the bucket that contains the percentile,
+	 * limited to the maximum value.
+	 */
+	int64_t percentile(double p) const
+	{
+		if (!mCount)
+			return 0;
+
+		uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * mCount + 0.5));
+		uint64_t sum = 0;
+		// The overflow bucket has no upper bound
+		for (std::size_t b = 0; b + 1 < mBuckets.size(); ++b)
+		{
+			sum += mBuckets[b];
+			if (sum >= rank)
+				return std::min<int64_t>(mMax, (b + 1) * mWidth);
+		}
+		return mMax;
+	}
+
+	void clear()
+	{
+		std::fill(mBuckets.begin(), mBuckets.end(), 0);
+		mCount = 0;
+		mSum = 0;
+		mMax = 0;
+	}
+
+private:
+	int64_t mWidth;
+	std::vector<uint64_t> mBuckets;
+	uint64_t mCount = 0;
+	int64_t mSum = 0;
+	int64_t mMax = 0;
+};
+
+} /* namespace qtouch */
+
+#endif /* HISTOGRAM_HPP_ */
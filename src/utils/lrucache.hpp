@@ -0,0 +1,158 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file lrucache.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef LRUCACHE_HPP_
+#define LRUCACHE_HPP_
+
+#include <cstddef>
+#include <list>
+#include <map>
+
+namespace qtouch
+{
+
+/**
+ * Cache that evicts the least recently used entries when the total cost
+ * of its entries exceeds the budget.
+ * Not thread safe.
+ */
+template<typename Key, typename Value>
+class LruCache
+{
+public:
+	explicit LruCache(std::size_t budget) : mBudget(budget), mCost(0), mHits(0), mMisses(0), mEvictions(0) {}
+
+	inline std::size_t budget() const { return mBudget; }
+	inline std::size_t cost() const { return mCost; }
+	inline std::size_t size() const { return mIndex.size(); }
+	inline std::size_t hits() const { return mHits; }
+	inline std::size_t misses() const { return mMisses; }
+	inline std::size_t evictions() const { return mEvictions; }
+
+	/** Change the budget. Evicts entries if necessary. */
+	void setBudget(std::size_t budget)
+	{
+		mBudget = budget;
+		trim();
+	}
+
+	/**
+	 * Lookup an entry and mark it as most recently used.
+	 * @return The value or nullptr. The pointer is valid until the next modification.
+	 */
+	const Value* get(const Key& key)
+	{
+		auto it = mIndex.find(key);
+		if (it == mIndex.end())
+		{
+			++mMisses;
+			return nullptr;
+		}
+
+		++mHits;
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		return &it->second->value;
+	}
+
+	/**
+	 * Insert or replace an entry.
+	 * An entry that is more expensive than the budget is not cached at all.
+	 */
+	void insert(const Key& key, const Value& value, std::size_t cost)
+	{
+		remove(key);
+		if (cost > mBudget)
+			return;
+
+		mEntries.push_front(Entry { key, value, cost });
+		mIndex[key] = mEntries.begin();
+		mCost += cost;
+		trim();
+	}
+
+	void remove(const Key& key)
+	{
+		auto it = mIndex.find(key);
+		if (it != mIndex.end())
+		{
+			mCost -= it->second->cost;
+			mEntries.erase(it->second);
+			mIndex.erase(it);
+		}
+	}
+
+	void clear()
+	{
+		mEntries.clear();
+		mIndex.clear();
+		mCost = 0;
+	}
+
+	/**
+	 * Visit all entries from the most to the least recently used without touching them.
+	 * @param f Callable with the signature void(const Key&, const Value&, std::size_t cost).
+	 */
+	template<typename F>
+	void forEach(F f) const
+	{
+		for (const Entry& e : mEntries)
+			f(e.key, e.value, e.cost);
+	}
+
+private:
+	struct Entry
+	{
+		Key key;
+		Value value;
+		std::size_t cost;
+	};
+
+	void trim()
+	{
+		while (mCost > mBudget && !mEntries.empty())
+		{
+			mCost -= mEntries.back().cost;
+			mIndex.erase(mEntries.back().key);
+			mEntries.pop_back();
+			++mEvictions;
+		}
+	}
+
+	std::size_t mBudget;
+	std::size_t mCost;
+	std::size_t mHits;
+	std::size_t mMisses;
+	std::size_t mEvictions;
+
+	/* Most recently used first */
+	std::list<Entry> mEntries;
+	std::map<Key, typename std::list<Entry>::iterator> mIndex;
+};
+
+} /* namespace qtouch */
+
+#endif /* LRUCACHE_HPP_ */
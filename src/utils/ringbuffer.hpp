@@ -0,0 +1,116 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * \file ringbuffer.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef RINGBUFFER_HPP_
+#define RINGBUFFER_HPP_
+
+#include <stdexcept>
+#include <vector>
+
+namespace qtouch
+{
+
+/**
+ * Fixed capacity buffer that overwrites its oldest element when full.
+ * The storage is allocated on construction, so push_back() never allocates.
+ * Index 0 refers to the oldest element.
+ */
+template<typename T>
+class RingBuffer
+{
+public:
+	typedef typename std::vector<T>::size_type size_type;
+
+	explicit RingBuffer(size_type capacity) : mBuffer(capacity), mHead(0), mSize(0), mDropped(0) {}
+
+	inline size_type capacity() const { return mBuffer.size(); }
+	inline size_type size() const { return mSize; }
+	inline bool empty() const { return !mSize; }
+	/** The number of elements that were overwritten or rejected since the last clear(). */
+	inline size_type dropped() const { return mDropped; }
+
+	void push_back(const T& value)
+	{
+		if (mBuffer.empty())
+		{
+			++mDropped;
+			return;
+		}
+
+		mBuffer[(mHead + mSize) % mBuffer.size()] = value;
+		if (mSize < mBuffer.size())
+		{
+			++mSize;
+		}
+		else
+		{
+			mHead = (mHead + 1) % mBuffer.size();
+			++mDropped;
+		}
+	}
+
+	inline const T& operator[](size_type i) const { return mBuffer[(mHead + i) % mBuffer.size()]; }
+	inline const T& at(size_type i) const
+	{
+		if (i >= mSize)
+			throw std::out_of_range("RingBuffer index out of range");
+		return (*this)[i];
+	}
+	inline const T& front() const { return (*this)[0]; }
+	inline const T& back() const { return (*this)[mSize - 1]; }
+
+	/** Remove all elements but keep the storage. */
+	inline void clear() { mHead = 0; mSize = 0; mDropped = 0; }
+
+	/** Remove all elements and change the capacity. This allocates! */
+	inline void reset(size_type capacity) { mBuffer.assign(capacity, T()); clear(); }
+
+	/**
+	 * Copy the elements from the oldest to the newest.
+	 * @param out An output iterator.
+	 * @return The output iterator behind the last copied element.
+	 */
+	template<typename OutputIter>
+	OutputIter copy(OutputIter out) const
+	{
+		for (size_type i = 0; i < mSize; ++i)
+		{
+			*out = (*this)[i];
+			++out;
+		}
+		return out;
+	}
+
+private:
+	std::vector<T> mBuffer;
+	size_type mHead;
+	size_type mSize;
+	size_type mDropped;
+};
+
+} /* namespace qtouch */
+
+#endif /* RINGBUFFER_HPP_ */
@@ -27,6 +27,10 @@
 #include <QtTest/QtTest>
 
 #include "utils.hpp"
+#include "ringbuffer.hpp"
+#include "histogram.hpp"
+#include "lrucache.hpp"
+#include "diagnostics.hpp"
 
 namespace qtouch
 {
@@ -39,6 +43,10 @@ private slots:
 	void smartPtrTraitsTest();
 	void getValueTest();
 	void scopedFlagTest();
+	void ringBufferTest();
+	void histogramTest();
+	void lruCacheTest();
+	void diagnosticsTest();
 };
 
 void UtilsTest::smartPtrTraitsTest()
@@ -187,6 +195,150 @@ void UtilsTest::scopedFlagTest()
 	QVERIFY(false == flag);
 }
 
+void UtilsTest::ringBufferTest()
+{
+	RingBuffer<int> rb(3);
+	QVERIFY(rb.empty());
+	QVERIFY(3 == rb.capacity());
+
+	rb.push_back(1);
+	rb.push_back(2);
+	QVERIFY(2 == rb.size());
+	QVERIFY(1 == rb.front());
+	QVERIFY(2 == rb.back());
+	QVERIFY(0 == rb.dropped());
+
+	// Overwrite the oldest
+	rb.push_back(3);
+	rb.push_back(4);
+	QVERIFY(3 == rb.size());
+	QVERIFY(1 == rb.dropped());
+	QVERIFY(2 == rb[0]);
+	QVERIFY(3 == rb[1]);
+	QVERIFY(4 == rb[2]);
+	QVERIFY_EXCEPTION_THROWN(rb.at(3), std::out_of_range);
+
+	std::vector<int> out;
+	rb.copy(std::back_inserter(out));
+	QVERIFY((std::vector<int> {2, 3, 4}) == out);
+
+	rb.clear();
+	QVERIFY(rb.empty());
+	QVERIFY(3 == rb.capacity());
+	QVERIFY(0 == rb.dropped());
+
+	// Zero capacity drops everything
+	rb.reset(0);
+	rb.push_back(1);
+	QVERIFY(rb.empty());
+	QVERIFY(1 == rb.dropped());
+}
+
+void UtilsTest::histogramTest()
+{
+	Histogram h(10, 10);
+	QVERIFY(0 == h.count());
+	QVERIFY(0 == h.percentile(0.5));
+
+	for (int i = 0; i < 100; ++i)
+		h.add(i);
+
+	QVERIFY(100 == h.count());
+	QVERIFY(99 == h.max());
+	QCOMPARE(h.mean(), 49.5);
+	QVERIFY(50 == h.percentile(0.5));
+	QVERIFY(99 == h.percentile(0.99));
+
+	// Overflow is limited by the maximum
+	h.add(1000);
+	QVERIFY(1000 == h.percentile(1));
+
+	h.clear();
+	QVERIFY(0 == h.count());
+	QVERIFY(0 == h.max());
+}
+
+void UtilsTest::lruCacheTest()
+{
+	LruCache<int, QString> cache(10);
+
+	cache.insert(1, QStringLiteral("one"), 4);
+	cache.insert(2, QStringLiteral("two"), 4);
+	QVERIFY(8 == cache.cost());
+	QVERIFY(nullptr == cache.get(3));
+	QVERIFY(1 == cache.misses());
+
+	// Touch 1 to make 2 the least recently used
+	QVERIFY(cache.get(1) && *cache.get(1) == QStringLiteral("one"));
+	QVERIFY(2 == cache.hits());
+
+	cache.insert(3, QStringLiteral("three"), 4);
+	QVERIFY(2 == cache.size());
+	QVERIFY(1 == cache.evictions());
+	QVERIFY(nullptr == cache.get(2));
+	QVERIFY(nullptr != cache.get(1));
+	QVERIFY(nullptr != cache.get(3));
+
+	// Replacing updates the cost
+	cache.insert(3, QStringLiteral("drei"), 2);
+	QVERIFY(6 == cache.cost());
+
+	// Too expensive to be cached
+	cache.insert(4, QStringLiteral("four"), 11);
+	QVERIFY(nullptr == cache.get(4));
+	QVERIFY(6 == cache.cost());
+
+	cache.setBudget(3);
+	QVERIFY(1 == cache.size());
+	QVERIFY(nullptr != cache.get(3));
+
+	cache.insert(5, QStringLiteral("five"), 1);
+	std::vector<int> keys;
+	std::size_t cost = 0;
+	cache.forEach([&](int key, const QString&, std::size_t c)
+	{
+		keys.push_back(key);
+		cost += c;
+	});
+	QVERIFY((std::vector<int> { 5, 3 }) == keys);
+	QVERIFY(cache.cost() == cost);
+
+	cache.clear();
+	QVERIFY(0 == cache.size());
+	QVERIFY(0 == cache.cost());
+}
+
+void UtilsTest::diagnosticsTest()
+{
+	const char* var = "QTOUCH_UTILS_TEST_DIAGNOSTICS";
+
+	qunsetenv(var);
+	QVERIFY(!diagnostics::isEnabled(var));
+	QVERIFY(!diagnostics::report(var, QStringLiteral("report")));
+
+	qputenv(var, "0");
+	QVERIFY(!diagnostics::isEnabled(var));
+
+	qputenv(var, "1");
+	QVERIFY(diagnostics::isEnabled(var));
+	QVERIFY(diagnostics::report(var, QStringLiteral("report")));
+
+	// Any other value is a file the reports are appended to
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString fileName = dir.path() + QStringLiteral("/report.txt");
+	qputenv(var, fileName.toLocal8Bit());
+	QVERIFY(diagnostics::isEnabled(var));
+	QVERIFY(diagnostics::report(var, QStringLiteral("first")));
+	QVERIFY(diagnostics::report(var, QStringLiteral("second")));
+
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+	QCOMPARE(QString::fromLocal8Bit(file.readAll()), QStringLiteral("first\nsecond\n"));
+
+	qunsetenv(var);
+}
+
 } /* namespace qtouch */
 
 QTEST_GUILESS_MAIN(qtouch::UtilsTest)
@@ -131,6 +131,7 @@ void QmlProfile::setName(const QString& name)
 		return;
 
 	mName = name;
+	mStats.setProfileName(name);
 	emit nameChanged();
 }
 
@@ -0,0 +1,158 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file manifest.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include "manifest.hpp"
+
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFile>
+
+#include "utils/exceptions.hpp"
+
+namespace qtouch
+{
+
+namespace xml
+{
+
+namespace
+{
+
+/* Increase when the serialized layout changes. Other versions are treated as empty. */
+const quint32 MANIFEST_VERSION = 1;
+
+} /* namespace */
+
+/**
+ * Record the size and digest of the given files.
+ * @param files File paths, e.g. of the course resources.
+ * @return The manifest with null course ids.
+ * @throw FileException if a file cannot be read.
+ */
+Manifest Manifest::scan(const QStringList& files)
+{
+	Manifest manifest;
+	manifest.mEntries.reserve(files.size());
+
+	for (const QString& f : files)
+	{
+		QFile file(f);
+		if (!file.open(QIODevice::ReadOnly))
+			throw FileException(file.errorString(), file.fileName());
+
+		QCryptographicHash digest(QCryptographicHash::Md5);
+		digest.addData(&file);
+
+		manifest.mEntries.push_back(Entry { f, file.size(), digest.result(), QUuid() });
+	}
+
+	return manifest;
+}
+
+/**
+ * Restore a manifest stored with toByteArray().
+ * @param data The serialized manifest.
+ * @return The manifest or an empty one when the data is empty, corrupt or of another version.
+ */
+Manifest Manifest::fromByteArray(const QByteArray& data)
+{
+	Manifest manifest;
+	if (data.isEmpty())
+		return manifest;
+
+	QDataStream in(data);
+	in.setVersion(QDataStream::Qt_5_6);
+
+	quint32 version = 0;
+	quint32 count = 0;
+	in >> version >> count;
+	if (version != MANIFEST_VERSION)
+		return manifest;
+
+	for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+	{
+		Entry e;
+		in >> e.file >> e.size >> e.digest >> e.courseId;
+		manifest.mEntries.push_back(e);
+	}
+
+	if (in.status() != QDataStream::Ok)
+		manifest.mEntries.clear();
+
+	return manifest;
+}
+
+QByteArray Manifest::toByteArray() const
+{
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+	out.setVersion(QDataStream::Qt_5_6);
+
+	out << MANIFEST_VERSION << static_cast<quint32>(mEntries.size());
+	for (const Entry& e : mEntries)
+		out << e.file << e.size << e.digest << e.courseId;
+
+	return data;
+}
+
+const Manifest::Entry* Manifest::find(const QString& file) const
+{
+	for (const Entry& e : mEntries)
+	{
+		if (e.file == file)
+			return &e;
+	}
+	return nullptr;
+}
+
+/**
+ * Check if a file is recorded with the same size and digest.
+ * @param current An entry of a freshly scanned manifest.
+ * @return The id of the course the file contained, a null id when it changed or is unknown.
+ */
+QUuid Manifest::unchangedCourse(const Entry& current) const
+{
+	const Entry* recorded = find(current.file);
+	if (recorded && recorded->size == current.size && recorded->digest == current.digest)
+		return recorded->courseId;
+	return QUuid();
+}
+
+bool Manifest::operator==(const Manifest& rhs) const
+{
+	return mEntries.size() == rhs.mEntries.size()
+	       && std::equal(mEntries.begin(), mEntries.end(), rhs.mEntries.begin(), [](const Entry& lhs, const Entry& rhs)
+	{
+		return lhs.file == rhs.file && lhs.size == rhs.size && lhs.digest == rhs.digest
+		       && lhs.courseId == rhs.courseId;
+	});
+}
+
+} /* namespace xml */
+
+} /* namespace qtouch */
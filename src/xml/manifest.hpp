@@ -0,0 +1,85 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file manifest.hpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef MANIFEST_HPP_
+#define MANIFEST_HPP_
+
+#include <vector>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QUuid>
+
+namespace qtouch
+{
+
+namespace xml
+{
+
+/**
+ * Describes the course files a database was built from.
+ * Comparing the name, size and digest of a file is a lot cheaper than
+ * validating and parsing it. Files that did not change can be taken from the
+ * database by the id of the course they contained.
+ */
+class Manifest
+{
+public:
+	struct Entry
+	{
+		QString file;
+		qint64 size;
+		QByteArray digest;
+		/* Null until the file was parsed or matched */
+		QUuid courseId;
+	};
+
+	static Manifest scan(const QStringList& files);
+
+	static Manifest fromByteArray(const QByteArray& data);
+	QByteArray toByteArray() const;
+
+	inline bool isEmpty() const { return mEntries.empty(); }
+	inline std::size_t size() const { return mEntries.size(); }
+	inline const std::vector<Entry>& getEntries() const { return mEntries; }
+	inline void setCourseId(std::size_t index, const QUuid& id) { mEntries.at(index).courseId = id; }
+
+	const Entry* find(const QString& file) const;
+	QUuid unchangedCourse(const Entry& current) const;
+
+	bool operator==(const Manifest& rhs) const;
+	inline bool operator!=(const Manifest& rhs) const { return !(*this == rhs); }
+
+private:
+	std::vector<Entry> mEntries;
+};
+
+} /* namespace xml */
+
+} /* namespace qtouch */
+
+#endif /* MANIFEST_HPP_ */
@@ -0,0 +1,146 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of QTouch.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/**
+ * \file manifest_test.cpp
+ *
+ * \date 18.10.2016
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <QtTest/QtTest>
+#include <QDir>
+#include <QTemporaryDir>
+
+#include "manifest.hpp"
+
+namespace qtouch
+{
+namespace xml
+{
+
+class ManifestTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void scanCourses();
+	void roundTrip();
+	void corruptData();
+	void detectChange();
+};
+
+namespace
+{
+
+/* The course resources */
+QStringList courseFiles()
+{
+	QDir coursepath(QStringLiteral(":/courses"), "*.xml", QDir::Name | QDir::IgnoreCase, QDir::Files);
+	QStringList files;
+	for (const auto& s : coursepath.entryList())
+		files.append(coursepath.filePath(s));
+	return files;
+}
+
+} /* namespace */
+
+void ManifestTest::scanCourses()
+{
+	QStringList files = courseFiles();
+	QVERIFY(!files.isEmpty());
+
+	Manifest manifest = Manifest::scan(files);
+	QCOMPARE(manifest.size(), static_cast<std::size_t>(files.size()));
+
+	for (const auto& e : manifest.getEntries())
+	{
+		QVERIFY(e.size > 0);
+		QCOMPARE(e.digest.size(), 16);
+		QVERIFY(e.courseId.isNull());
+	}
+
+	// Unchanged files are matched but the course id is unknown
+	const auto& first = manifest.getEntries().front();
+	QVERIFY(manifest.find(first.file));
+	QVERIFY(manifest.unchangedCourse(first).isNull());
+	QVERIFY(!manifest.find(QStringLiteral(":/courses/missing.xml")));
+}
+
+void ManifestTest::roundTrip()
+{
+	Manifest manifest = Manifest::scan(courseFiles());
+	for (std::size_t i = 0; i < manifest.size(); ++i)
+		manifest.setCourseId(i, QUuid::createUuid());
+
+	Manifest restored = Manifest::fromByteArray(manifest.toByteArray());
+	QVERIFY(restored == manifest);
+
+	for (const auto& e : manifest.getEntries())
+		QCOMPARE(restored.unchangedCourse(e), e.courseId);
+}
+
+void ManifestTest::corruptData()
+{
+	QVERIFY(Manifest::fromByteArray(QByteArray()).isEmpty());
+
+	QByteArray data = Manifest::scan(courseFiles()).toByteArray();
+	QVERIFY(Manifest::fromByteArray(data.left(data.size() / 2)).isEmpty());
+
+	// Unknown version
+	data[3] = data[3] + 1;
+	QVERIFY(Manifest::fromByteArray(data).isEmpty());
+}
+
+void ManifestTest::detectChange()
+{
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	const QString path = dir.path() + QStringLiteral("/course.xml");
+
+	auto writeFile = [&path](const QByteArray& content)
+	{
+		QFile f(path);
+		QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+		f.write(content);
+	};
+
+	writeFile("<course>a</course>");
+	Manifest recorded = Manifest::scan(QStringList { path });
+	const QUuid id = QUuid::createUuid();
+	recorded.setCourseId(0, id);
+
+	QCOMPARE(recorded.unchangedCourse(Manifest::scan(QStringList { path }).getEntries().front()), id);
+
+	// Same size, different content
+	writeFile("<course>b</course>");
+	Manifest current = Manifest::scan(QStringList { path });
+	QVERIFY(recorded.unchangedCourse(current.getEntries().front()).isNull());
+	QVERIFY(recorded != current);
+
+	QVERIFY_EXCEPTION_THROWN(Manifest::scan(QStringList { dir.path() + QStringLiteral("/missing.xml") }),
+	                         FileException);
+}
+
+} /* namespace xml */
+} /* namespace qtouch */
+
+QTEST_GUILESS_MAIN(qtouch::xml::ManifestTest)
+#include "manifest_test.moc"